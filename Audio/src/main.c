@@ -2,16 +2,30 @@
 SDL2 Audio Demo
 */
 
-#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL_mixer.h>
 
+#include "assets.h"
+#include "atlas.h"
+#include "audio.h"
+#include "batch.h"
+#include "bench.h"
+#include "bubbles.h"
+#include "events.h"
+#include "jobs.h"
+#include "options.h"
+#include "pacer.h"
+#include "pixels.h"
+#include "simulation.h"
+#include "sounds.h"
+#include "stream.h"
+#include "telemetry.h"
+
 
 //Macros
 //===========================================================================
@@ -29,32 +43,14 @@ SDL2 Audio Demo
 #define WINDOW_HEIGHT     600
 
 #ifdef __ANDROID__
-#define WINDOW_FLAGS      SDL_WINDOW_FULLSCREEN
+    #define WINDOW_FLAGS  SDL_WINDOW_FULLSCREEN
 #else
-#define WINDOW_FLAGS      0
+    #define WINDOW_FLAGS  0
 #endif
 
-#define FPS               60
-#define TARGET_FRAME_TIME (1000 / FPS)
-
-
-//Types
-//===========================================================================
-typedef struct
-{
-    SDL_Texture *tex;
-    SDL_Rect rect;
-} Pin;
-
-
-typedef struct
-{
-    SDL_Texture *tex;
-    SDL_Rect rect;
-    SDL_FPoint pos;
-    SDL_FPoint velocity;
-    int hp;
-} Bubble;
+#define SPRITE_SCALE      200 //sprites are drawn at twice their image size
+#define POP_PRIORITY      0
+#define PIN_POP_PRIORITY  1   //the player should always hear their own pops
 
 
 //Globals
@@ -64,41 +60,71 @@ SDL_Renderer *renderer = NULL;
 
 SDL_Point windowSize;
 
-int startTime = 0;
-int endTime = 0;
-int frameTime = 0;
+const Uint32 handledEvents[] = {
+    SDL_QUIT,
+    SDL_KEYDOWN,
+    SDL_MOUSEBUTTONDOWN,
+    SDL_MOUSEBUTTONUP,
+    SDL_MOUSEMOTION
+};
+
+Options options;
+EventBatch eventBatch;
+FramePacer pacer;
+
+const char *imageFiles[] = {
+    "data/images/bubble.png",
+    "data/images/pin.png",
+    "data/images/popping-bubble.png"
+};
+
+const int spriteScales[] = {SPRITE_SCALE};
 
-SDL_Texture *pinTex = NULL;
-Pin pin;
+Atlas atlas;
+SpriteBatch spriteBatch;
+const SDL_Color white = {255, 255, 255, 255};
 
-int spawnTmr = 60;
-SDL_Texture *bubbleTex = NULL;
-SDL_Texture *poppingBubbleTex = NULL;
+const SDL_Rect *pinSprite = NULL;
+SDL_Rect pinRect;
+
+const SDL_Rect *bubbleSprite = NULL;
+const SDL_Rect *poppingBubbleSprite = NULL;
 SDL_Rect bubbleRect;
-Bubble bubbles[10];
+Uint32 playedPops = 0;
+Uint32 playedPinPops = 0;
 
 int haveAudio = TRUE;
-Mix_Chunk *poppingBubbleSnd = NULL;
+Asset *poppingBubbleSnd = NULL;
+SoundStream music;
 
 
 //Functions
 //===========================================================================
 void Quit(void)
 {
+    //Stop the simulation thread and free its state
+    FreeSimulation();
+    
+    //Stop the job threads
+    FreeJobSystem();
+    
     //Free audio data
     Mix_HaltChannel(-1);
     
-    if(poppingBubbleSnd)
-    {
-        Mix_FreeChunk(poppingBubbleSnd);
-    }
-
-    //Close audio device
+    //Close audio device, which also stops the soft mixer's voices, before
+    //the sounds they play from are freed
     if(haveAudio)
     {
-        Mix_CloseAudio();
+        CloseAudio();
     }
     
+    //Close the music once nothing can be reading from it
+    CloseSoundStream(&music);
+    
+    //Free sprite batch and cached assets
+    FreeSpriteBatch(&spriteBatch);
+    FreeAssetCache();
+    
     //Destroy renderer and window
     if(renderer)
     {
@@ -118,14 +144,24 @@ void Quit(void)
 }
 
 
-SDL_Texture *LoadImage(const char *filename, SDL_Rect *rect)
+int InitAtlas(void)
+{
+    //Pack every image into a single texture
+    return BuildAtlas(&atlas, renderer, imageFiles, 
+        sizeof(imageFiles) / sizeof(imageFiles[0]), spriteScales, 
+        sizeof(spriteScales) / sizeof(spriteScales[0]));
+}
+
+
+const SDL_Rect *LoadSprite(const char *filename, SDL_Rect *rect)
 {
-    //Load the image file
-    SDL_Surface *img = IMG_Load(filename);
+    //Look up the image in the atlas at the size it is drawn
+    const SDL_Rect *sprite = FindAtlasRegion(&atlas, filename, SPRITE_SCALE);
     
-    if(!img)
+    if(!sprite)
     {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s is not in the atlas.",
+            filename);
         return NULL;
     }
     
@@ -134,65 +170,48 @@ SDL_Texture *LoadImage(const char *filename, SDL_Rect *rect)
     {
         rect->x = 0;
         rect->y = 0;
-        rect->w = img->w;
-        rect->h = img->h;
+        rect->w = sprite->w;
+        rect->h = sprite->h;
     }
     
-    //Create a texture from the image
-    SDL_Texture *tex = SDL_CreateTextureFromSurface(renderer, img);
-    
-    if(!tex)
-    {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
-    }
-    
-    //Free the image and return the texture
-    SDL_FreeSurface(img);
-    return tex;
+    return sprite;
 }
 
 
 int InitPin(void)
 {
-    //Load pin texture
-    pinTex = LoadImage("data/images/pin.png", &pin.rect);
+    //Look up pin sprite
+    pinSprite = LoadSprite("data/images/pin.png", &pinRect);
     
-    if(!pinTex)
+    if(!pinSprite)
     {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s",
-            "Failed to load pin texture.");
+            "Failed to load pin sprite.");
         return 1;
     }
     
-    pin.rect.w *= 2;
-    pin.rect.h *= 2;
     return 0;
 }
 
 
 int InitBubbles(void)
 {
-    //Initialize bubbles array
-    memset(bubbles, 0, sizeof(bubbles));
-    
-    //Load bubble textures
-    bubbleTex = LoadImage("data/images/bubble.png", &bubbleRect);
+    //Look up bubble sprites
+    bubbleSprite = LoadSprite("data/images/bubble.png", &bubbleRect);
     
-    if(!bubbleTex)
+    if(!bubbleSprite)
     {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", 
-            "Failed to load bubble textures.");
+            "Failed to load bubble sprites.");
         return 1;
     }
     
-    bubbleRect.w *= 2;
-    bubbleRect.h *= 2;
-    poppingBubbleTex = LoadImage("data/images/popping-bubble.png", NULL);
+    poppingBubbleSprite = LoadSprite("data/images/popping-bubble.png", NULL);
     
-    if(!poppingBubbleTex)
+    if(!poppingBubbleSprite)
     {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", 
-            "Failed to load bubble textures.");
+            "Failed to load bubble sprites.");
         return 1;
     }
     
@@ -202,12 +221,23 @@ int InitBubbles(void)
 
 void InitAudio(void)
 {
+    //Set up the voices sounds are played on
+    InitSounds(options.voices);
+    
     //Load popping bubble sound effect
-    poppingBubbleSnd = Mix_LoadWAV("data/sounds/popping-bubble.ogg");
+    poppingBubbleSnd = LoadSoundAsync("data/sounds/popping-bubble.ogg");
     
     if(!poppingBubbleSnd)
     {
-        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "%s", 
+            "Failed to load popping bubble sound.");
+    }
+    
+    //Loop the music, streaming it from disk if it is large
+    if(options.musicFile && OpenSoundStream(&music, options.musicFile, TRUE, 
+        options.streamThreshold) == 0)
+    {
+        PlayAudioStream(&music);
     }
 }
 
@@ -254,6 +284,9 @@ int Init(void)
     }
     
     SDL_SetWindowTitle(window, APP_TITLE);
+    InitPixelFormat(window, renderer);
+    InitAssetCache(renderer);
+    OpenAssetPack("data/assets.pack");
     SDL_SetWindowPosition(window, WINDOW_X, WINDOW_Y);
     
     #ifdef __ANDROID__
@@ -270,15 +303,39 @@ int Init(void)
     {
         SDL_Log("%s", "Opening audio device...");
     
-        if(Mix_OpenAudio(MIX_DEFAULT_FREQUENCY, MIX_DEFAULT_FORMAT, 2, 4096) == -1)
+        if(OpenAudio(options.audioRate, options.audioChannels, 
+            options.audioBuffer, options.softMixer))
         {
             SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
             haveAudio = FALSE;
         }
     }
     
-    //Init random numbers
-    srand(time(0));
+    //Start recording or replaying input, which may change the options and
+    //the area the bubbles move in
+    if(InitSimulationReplay(&options, &windowSize))
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", 
+            "Failed to start input replay.");
+        return 1;
+    }
+    
+    //Start the job threads
+    InitJobSystem(options.jobs);
+    
+    //Init sprite atlas
+    if(InitAtlas())
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s",
+            "Failed to build sprite atlas.");
+        return 1;
+    }
+    
+    //Init sprite batch
+    if(InitSpriteBatch(&spriteBatch, renderer))
+    {
+        return 1;
+    }
     
     //Init pin
     if(InitPin())
@@ -296,6 +353,14 @@ int Init(void)
         return 1;
     }
     
+    //Init simulation
+    if(InitSimulation(&options, &windowSize, &bubbleRect, &pinRect))
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s",
+            "Failed to initialize simulation.");
+        return 1;
+    }
+    
     //Load audio files
     if(haveAudio)
     {
@@ -306,193 +371,62 @@ int Init(void)
 }
 
 
-int randint(int min, int max)
-{
-    return min + (rand() % (max - min));
-}
-
-
-float radians(float degrees)
-{
-    return degrees * (M_PI / 180.0f);
-}
-
-
-void center(SDL_Point *center, const SDL_Rect *rect)
-{
-    center->x = rect->x + rect->w / 2;
-    center->y = rect->y + rect->h / 2;
-}
-
-
-void SpawnBubble(void)
-{
-    //Update spawn timer
-    if(spawnTmr--)
-    {
-        return;
-    }
-    
-    //Reset spawn timer
-    spawnTmr = 60;
-    
-    //Spawn a bubble
-    for(int i = 0; i < sizeof(bubbles) / sizeof(bubbles[0]); i++)
-    {
-        Bubble *bubble = &bubbles[i];
-        
-        if(bubble->tex)
-        {
-            continue;
-        }
-        
-        bubble->tex = bubbleTex;
-        memcpy(&bubble->rect, &bubbleRect, sizeof(bubbleRect));
-        bubble->pos.x = randint(0, windowSize.x - bubbleRect.w);
-        bubble->pos.y = randint(0, windowSize.y - bubbleRect.h);
-        bubble->velocity.x = cos(radians(randint(0, 360)));
-        bubble->velocity.y = sin(radians(randint(0, 360)));
-        bubble->hp = 100;
-        return;
-    }
-}
-
-
-void SetPinPos(int x, int y)
-{
-    pin.rect.x = x;
-    pin.rect.y = y;
-}
-
-
-void ShowPin(int doShow)
-{
-    //Show the pin?
-    if(doShow)
-    {
-        pin.tex = pinTex;
-    }
-    //Hide the pin?
-    else
-    {
-        pin.tex = NULL;
-    }
-}
-
-
-void UpdatePin(void)
+void DrawPin(const Pin *pinState)
 {
     //Is the pin visible?
-    if(!pin.tex)
+    if(!pinState->visible)
     {
         return;
     }
     
     //Render the pin
-    SDL_RenderCopy(renderer, pin.tex, NULL, &pin.rect);
+    DrawSprite(&spriteBatch, atlas.tex, pinSprite, &pinState->rect, 
+        white);
 }
 
 
-void PopBubble(Bubble *bubble)
+void PlayPops(const Snapshot *snapshot)
 {
-    bubble->tex = poppingBubbleTex;
-    bubble->hp = -30;
+    //Trigger a sound for every pop that is about to be seen for the first
+    //time. They all end up in one voice, however many there are.
+    int canPlay = haveAudio && IsAssetReady(poppingBubbleSnd);
     
-    if(haveAudio && poppingBubbleSnd)
-    {
-        Mix_PlayChannel(-1, poppingBubbleSnd, 0);
-    }
-}
-
-
-void UpdateBubble(Bubble *bubble)
-{
-    //Does this bubble exist?
-    if(!bubble->tex || !bubble->hp)
-    {
-        return;
-    }
-    //Is this bubble popped?
-    else if(bubble->hp < 0)
+    for(; playedPinPops != snapshot->pinPops; playedPinPops++)
     {
-        if(++bubble->hp == 0)
+        if(canPlay)
         {
-            bubble->tex = NULL;
-            return;
+            TriggerSound(poppingBubbleSnd->data.chunk, PIN_POP_PRIORITY);
         }
-    }
-    //Is this bubble active?
-    else
-    {
-        //Do collision detection
-        if(pin.tex && SDL_HasIntersection(&bubble->rect, &pin.rect))
-        {
-            PopBubble(bubble);
-        }
-        else
-        {
-            for(int i = 0; i < sizeof(bubbles) / sizeof(bubbles[0]); i++)
-            {
-                Bubble *bubble2 = &bubbles[i];
-            
-                //Don't check collision between a bubble and itself or with a bubble
-                //that doesn't exist.
-                if(bubble == bubble2 || !bubble2->tex || bubble2->hp <= 0)
-                {
-                    continue;
-                }
         
-                //Have the bubbles collided
-                SDL_Point p1;
-                SDL_Point p2;
-                center(&p1, &bubble->rect);
-                center(&p2, &bubble2->rect);
-            
-                int dx = p2.x - p1.x;
-                int dy = p2.y - p1.y;
-            
-                if(sqrt((float)(dx * dx + dy * dy)) < 
-                    bubble->rect.w / 2 + bubble2->rect.h / 2)
-                {
-                    bubble->velocity.x = -bubble->velocity.x;
-                    bubble->velocity.y = -bubble->velocity.y;
-            
-                    if(--bubble->hp == 0)
-                    {
-                        PopBubble(bubble);
-                    }
-            
-                    bubble2->velocity.x = -bubble2->velocity.x;
-                    bubble2->velocity.y = -bubble2->velocity.y;
-            
-                    if(--bubble2->hp == 0)
-                    {
-                        PopBubble(bubble2);
-                    }
-                }
-            }
-        }
-    
-        //Update pos and velocity
-        bubble->pos.x += bubble->velocity.x;
-        bubble->pos.y += bubble->velocity.y;
-    
-        if(bubble->pos.x < 0 || bubble->pos.x + bubble->rect.w > windowSize.x)
-        {
-            bubble->velocity.x = -bubble->velocity.x;
-        }
+        playedPops++;
+    }
     
-        if(bubble->pos.y < 0 || bubble->pos.y + bubble->rect.h > windowSize.y)
+    for(; playedPops != snapshot->pops; playedPops++)
+    {
+        if(canPlay)
         {
-            bubble->velocity.y = -bubble->velocity.y;
+            TriggerSound(poppingBubbleSnd->data.chunk, POP_PRIORITY);
         }
+    }
     
-        bubble->rect.x = bubble->pos.x;
-        bubble->rect.y = bubble->pos.y;
+    if(canPlay)
+    {
+        FlushSounds();
     }
+}
+
+
+void DrawBubble(const BubbleStore *store, int i, float alpha)
+{
+    //Interpolate between the previous and the current simulation step
+    SDL_Rect rect = bubbleRect;
+    rect.x = store->prevX[i] + (store->x[i] - store->prevX[i]) * alpha;
+    rect.y = store->prevY[i] + (store->y[i] - store->prevY[i]) * alpha;
     
     //Draw the bubble
-    SDL_RenderCopy(renderer, bubble->tex, NULL, &bubble->rect);
+    const SDL_Rect *sprite = store->state[i] == BUBBLE_ACTIVE ? 
+        bubbleSprite : poppingBubbleSprite;
+    DrawSprite(&spriteBatch, atlas.tex, sprite, &rect, white);
 }
 
 
@@ -500,6 +434,17 @@ void UpdateBubble(Bubble *bubble)
 //===========================================================================
 int main(int argc, char **argv)
 {
+    //Parse command line options
+    if(ParseOptions(&options, argc, argv, OPTIONS_SIMULATION | OPTIONS_AUDIO))
+    {
+        return 1;
+    }
+    
+    if(options.bench)
+    {
+        PrepareBenchMode();
+    }
+    
     //Init
     if(Init())
     {
@@ -510,66 +455,129 @@ int main(int argc, char **argv)
     
     //Main Loop
     SDL_Log("%s", "Starting main loop...");
+    InstallEventFilter(handledEvents, 
+        sizeof(handledEvents) / sizeof(handledEvents[0]));
+    InitFramePacer(&pacer, options.fps);
+    
+    if(StartSimulation(options.bench || options.fastReplay))
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", 
+            "Failed to start simulation.");
+        return 1;
+    }
+    
+    InitTelemetry();
+    StartBenchClock();
+    int frames = 0;
     
     while(TRUE)
     {
         //Process pending events
-        SDL_Event event;
+        PollEventBatch(&eventBatch);
         
-        while(SDL_PollEvent(&event))
+        for(int i = 0; i < eventBatch.count; i++)
         {
+            SDL_Event *event = &eventBatch.events[i];
+            
             //Handle the next event
-            switch(event.type)
+            switch(event->type)
             {
                 //Quit Event
             case SDL_QUIT:
+                DumpTelemetry(options.telemetryFile);
                 return 0;
                 
-                //Mouse Button Down Event
-            case SDL_MOUSEBUTTONDOWN:
-                ShowPin(TRUE);
-                SetPinPos(event.button.x, event.button.y);
-                break;
+                //Key Down Event
+            case SDL_KEYDOWN:
+                //Dump telemetry on demand
+                if(event->key.keysym.sym == SDLK_F2)
+                {
+                    DumpTelemetry(options.telemetryFile);
+                }
                 
-                //Mouse Button Up Event
-            case SDL_MOUSEBUTTONUP:
-                ShowPin(FALSE);
                 break;
                 
-                //Mouse Motion Event
+                //Mouse Events
+            case SDL_MOUSEBUTTONDOWN:
+            case SDL_MOUSEBUTTONUP:
             case SDL_MOUSEMOTION:
-                SetPinPos(event.motion.x, event.motion.y);
+                //Replays bring their own mouse input
+                if(!IsSimulationReplaying())
+                {
+                    HandlePinEvent(event);
+                }
+                
                 break;
             }
         }
         
+        MarkTelemetryPhase(TELEMETRY_EVENTS);
+        
+        //Grab the latest simulation snapshot
+        const Snapshot *snapshot = GetSimulationSnapshot(
+            frames + 1 == options.frames);
+        
+        //Start the pop sounds in the same frame as the pops
+        PlayPops(snapshot);
+        
         //Clear the window
         SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
         SDL_RenderClear(renderer);
         
-        //Update pin
-        UpdatePin();
+        //Draw pin
+        Pin shownPin = snapshot->pin;
+        
+        if(options.lateLatch && !IsSimulationReplaying())
+        {
+            LatchPin(&shownPin);
+        }
         
-        //Update bubbles
-        SpawnBubble();
+        DrawPin(&shownPin);
         
-        for(int i = 0; i < sizeof(bubbles) / sizeof(bubbles[0]); i++)
+        //Draw bubbles
+        float alpha = GetSnapshotAlpha(snapshot);
+        
+        for(int i = 0; i < snapshot->bubbles.count; i++)
         {
-            UpdateBubble(&bubbles[i]);
+            DrawBubble(&snapshot->bubbles, i, alpha);
         }
         
+        FlushSpriteBatch(&spriteBatch);
+        MarkTelemetryPhase(TELEMETRY_DRAW);
+        
         //Swap buffers
         SDL_RenderPresent(renderer);
-        endTime = SDL_GetTicks();
-        frameTime = endTime - startTime;
-        startTime = endTime;
+        MarkTelemetryPhase(TELEMETRY_PRESENT);
+        
+        //Measure how long input took to reach the screen
+        RecordEventLatency(TELEMETRY_INPUT_LATENCY, shownPin.inputTime);
+        RecordEventLatency(TELEMETRY_POP_LATENCY, snapshot->popInputTime);
+        
+        //Limit framerate
+        WaitForNextFrame(&pacer);
+        MarkTelemetryPhase(TELEMETRY_SLEEP);
+        RecordTelemetry(TELEMETRY_JITTER, (float)GetFrameJitter(&pacer));
+        EndTelemetryFrame();
+        
+        //Stop after the requested number of frames
+        if(++frames == options.frames)
+        {
+            break;
+        }
         
-        //Limit framerate to 60 fps.
-        if(frameTime < TARGET_FRAME_TIME)
+        //Stop when the replay runs out of input
+        if(IsSimulationDone())
         {
-            SDL_Delay(TARGET_FRAME_TIME - frameTime);
+            break;
         }
     }
     
+    //Report results
+    if(options.bench)
+    {
+        PrintBenchReport(APP_TITLE, frames);
+    }
+    
+    DumpTelemetry(options.telemetryFile);
     return 0;
 }
\ No newline at end of file
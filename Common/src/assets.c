@@ -0,0 +1,660 @@
+/*
+SDL2 Asset Cache
+*/
+
+#include <SDL2/SDL_image.h>
+
+#include "assets.h"
+#include "pack.h"
+#include "pixels.h"
+
+
+//Macros
+//===========================================================================
+#define MAX_LOADERS 16 //upper limit on decoding threads
+
+
+//Globals
+//===========================================================================
+static SDL_Renderer *cacheRenderer = NULL;
+static Asset *assets = NULL;
+static SDL_atomic_t assetMemory;
+static AssetPack pack;
+
+//Loader pool
+static SDL_Thread *loaders[MAX_LOADERS];
+static int loaderCount = 0;
+static int loadersRunning = 0;
+static SDL_mutex *loadLock = NULL;
+static SDL_cond *loadCond = NULL;
+static Asset *loadQueue = NULL;
+static Asset **loadTail = &loadQueue;
+static Asset *uploadQueue = NULL;
+static Asset **uploadTail = &uploadQueue;
+static SDL_atomic_t pendingAssets;
+static Uint64 loadStart = 0;
+
+#ifdef USE_SDL_TTF
+static SDL_SpinLock fontLock = 0;
+#endif
+
+
+//Functions
+//===========================================================================
+static int SDLCALL LoaderThread(void *data);
+
+
+void InitAssetCache(SDL_Renderer *renderer)
+{
+    cacheRenderer = renderer;
+    assets = NULL;
+    SDL_AtomicSet(&assetMemory, 0);
+    SDL_AtomicSet(&pendingAssets, 0);
+    loadQueue = NULL;
+    loadTail = &loadQueue;
+    uploadQueue = NULL;
+    uploadTail = &uploadQueue;
+    loaderCount = 0;
+    
+    //Start one decoding thread per core
+    loadLock = SDL_CreateMutex();
+    loadCond = SDL_CreateCond();
+    
+    if(!loadLock || !loadCond)
+    {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+        return;
+    }
+    
+    int count = SDL_min(SDL_GetCPUCount(), MAX_LOADERS);
+    loadersRunning = 1;
+    
+    while(loaderCount < count)
+    {
+        loaders[loaderCount] = SDL_CreateThread(&LoaderThread, "Loader", 
+            NULL);
+        
+        if(!loaders[loaderCount])
+        {
+            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+            break;
+        }
+        
+        loaderCount++;
+    }
+}
+
+
+static void StopLoaders(void)
+{
+    //Let the loaders finish their queued work and exit
+    if(loadLock)
+    {
+        SDL_LockMutex(loadLock);
+        loadersRunning = 0;
+        SDL_CondBroadcast(loadCond);
+        SDL_UnlockMutex(loadLock);
+    }
+    
+    while(loaderCount > 0)
+    {
+        SDL_WaitThread(loaders[--loaderCount], NULL);
+    }
+    
+    if(loadCond)
+    {
+        SDL_DestroyCond(loadCond);
+        loadCond = NULL;
+    }
+    
+    if(loadLock)
+    {
+        SDL_DestroyMutex(loadLock);
+        loadLock = NULL;
+    }
+}
+
+
+static void UnloadAsset(Asset *asset)
+{
+    //Free the underlying data
+    switch(asset->type)
+    {
+    case ASSET_TEXTURE:
+        if(asset->data.tex)
+        {
+            SDL_DestroyTexture(asset->data.tex);
+        }
+        
+        break;
+        
+    case ASSET_SURFACE:
+        SDL_FreeSurface(asset->data.surface);
+        break;
+        
+    #ifdef USE_SDL_MIXER
+    case ASSET_SOUND:
+        if(asset->data.chunk)
+        {
+            Mix_FreeChunk(asset->data.chunk);
+        }
+        
+        break;
+    #endif
+    
+    #ifdef USE_SDL_TTF
+    case ASSET_FONT:
+        if(asset->data.font)
+        {
+            TTF_CloseFont(asset->data.font);
+        }
+        
+        break;
+    #endif
+    
+    default:
+        break;
+    }
+    
+    SDL_FreeSurface(asset->pixels);
+    SDL_AtomicAdd(&assetMemory, -(int)asset->bytes);
+    SDL_free(asset->path);
+    SDL_free(asset);
+}
+
+
+void FreeAssetCache(void)
+{
+    //Make sure no loader is still touching an asset
+    StopLoaders();
+    uploadQueue = NULL;
+    uploadTail = &uploadQueue;
+    
+    //Free every asset regardless of how many references are left
+    while(assets)
+    {
+        Asset *next = assets->next;
+        UnloadAsset(assets);
+        assets = next;
+    }
+    
+    //Nothing refers to the pack any more
+    ClosePack(&pack);
+}
+
+
+int OpenAssetPack(const char *filename)
+{
+    //Pre-decoded assets are used in place of the files they came from
+    if(OpenPack(&pack, filename))
+    {
+        SDL_Log("%s", "No asset pack found, decoding assets from files.");
+        return 1;
+    }
+    
+    SDL_Log("Using asset pack %s (%u assets)", filename, 
+        (unsigned)pack.header->count);
+    return 0;
+}
+
+
+static Asset *FindAsset(AssetType type, const char *path, int param)
+{
+    //Is this asset already loaded?
+    for(Asset *asset = assets; asset; asset = asset->next)
+    {
+        if(asset->type == type && asset->param == param && 
+            SDL_strcmp(asset->path, path) == 0)
+        {
+            asset->refs++;
+            return asset;
+        }
+    }
+    
+    return NULL;
+}
+
+
+static Asset *NewAsset(AssetType type, const char *path, int param)
+{
+    //Create a new cache entry
+    Asset *asset = (Asset*)SDL_calloc(1, sizeof(Asset));
+    
+    if(!asset || !(asset->path = SDL_strdup(path)))
+    {
+        SDL_free(asset);
+        SDL_OutOfMemory();
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+        return NULL;
+    }
+    
+    asset->type = type;
+    asset->param = param;
+    asset->refs = 1;
+    SDL_AtomicSet(&asset->state, ASSET_PENDING);
+    
+    //Link it into the cache straight away so later requests share it
+    asset->next = assets;
+    assets = asset;
+    
+    SDL_LockMutex(loadLock);
+    
+    if(SDL_AtomicIncRef(&pendingAssets) == 0)
+    {
+        loadStart = SDL_GetPerformanceCounter();
+    }
+    
+    SDL_UnlockMutex(loadLock);
+    
+    return asset;
+}
+
+
+static void FinishAsset(Asset *asset, size_t bytes)
+{
+    //Publish the result of a load
+    if(bytes)
+    {
+        asset->bytes = bytes;
+        SDL_AtomicAdd(&assetMemory, (int)bytes);
+    }
+    
+    SDL_AtomicSet(&asset->state, bytes ? ASSET_READY : ASSET_FAILED);
+    
+    //Report how long it took to load everything that was requested
+    SDL_LockMutex(loadLock);
+    
+    if(SDL_AtomicDecRef(&pendingAssets))
+    {
+        SDL_Log("Assets loaded in %.2f ms (%u KB)", 
+            (double)(SDL_GetPerformanceCounter() - loadStart) * 1000.0 / 
+            SDL_GetPerformanceFrequency(), 
+            (unsigned)(GetAssetMemory() / 1024));
+    }
+    
+    SDL_UnlockMutex(loadLock);
+}
+
+
+static SDL_Surface *LoadPackedImage(const char *path)
+{
+    const PackEntry *entry = FindPackEntry(&pack, path, PACK_IMAGE);
+    
+    if(!entry || entry->rawSize < (Uint32)(entry->pitch * entry->height))
+    {
+        return NULL;
+    }
+    
+    //Use the pixels in place when they are stored uncompressed
+    const void *pixels = GetPackData(&pack, entry);
+    int depth = SDL_BITSPERPIXEL(entry->format);
+    
+    if(pixels)
+    {
+        return SDL_CreateRGBSurfaceWithFormatFrom((void*)pixels, entry->width, 
+            entry->height, depth, entry->pitch, entry->format);
+    }
+    
+    //Otherwise decompress them into a new surface
+    SDL_Surface *img = SDL_CreateRGBSurfaceWithFormat(0, entry->width, 
+        entry->height, depth, entry->format);
+    
+    if(img && (img->pitch != entry->pitch || 
+        ReadPackEntry(&pack, entry, img->pixels)))
+    {
+        SDL_FreeSurface(img);
+        return NULL;
+    }
+    
+    return img;
+}
+
+
+static SDL_Surface *LoadImageFile(const char *path, int scale)
+{
+    //Load the image from the pack or decode its file, then convert it to 
+    //the format the renderer wants and resample it to the size it is drawn
+    SDL_Surface *img = LoadPackedImage(path);
+    return ScaleSurface(PrepareSurface(img ? img : IMG_Load(path)), scale);
+}
+
+
+#ifdef USE_SDL_MIXER
+static Mix_Chunk *LoadPackedSound(const char *path)
+{
+    const PackEntry *entry = FindPackEntry(&pack, path, PACK_SOUND);
+    int freq;
+    Uint16 format;
+    int channels;
+    
+    //The samples are only usable if the mixer runs in the same format
+    if(!entry || !Mix_QuerySpec(&freq, &format, &channels) || 
+        freq != pack.header->audioFreq || format != pack.header->audioFormat || 
+        channels != pack.header->audioChannels)
+    {
+        return NULL;
+    }
+    
+    //Play uncompressed samples straight from the pack
+    const void *samples = GetPackData(&pack, entry);
+    
+    if(samples)
+    {
+        return Mix_QuickLoad_RAW((Uint8*)samples, entry->rawSize);
+    }
+    
+    //Otherwise decompress them into a chunk that owns its samples
+    Mix_Chunk *chunk = (Mix_Chunk*)SDL_malloc(sizeof(Mix_Chunk));
+    Uint8 *buf = (Uint8*)SDL_malloc(entry->rawSize);
+    
+    if(!chunk || !buf || ReadPackEntry(&pack, entry, buf))
+    {
+        SDL_free(chunk);
+        SDL_free(buf);
+        return NULL;
+    }
+    
+    chunk->allocated = 1;
+    chunk->abuf = buf;
+    chunk->alen = entry->rawSize;
+    chunk->volume = MIX_MAX_VOLUME;
+    return chunk;
+}
+#endif
+
+
+#ifdef USE_SDL_TTF
+static SDL_RWops *OpenPackedFont(const char *path)
+{
+    //Fonts are stored uncompressed so they can be read in place
+    const PackEntry *entry = FindPackEntry(&pack, path, PACK_FONT);
+    const void *data = entry ? GetPackData(&pack, entry) : NULL;
+    return data ? SDL_RWFromConstMem(data, (int)entry->size) : NULL;
+}
+
+
+static TTF_Font *OpenFont(const char *path, int ptSize, size_t *bytes)
+{
+    //Open the font from the pack or from its file
+    SDL_RWops *file = OpenPackedFont(path);
+    
+    if(!file)
+    {
+        file = SDL_RWFromFile(path, "rb");
+    }
+    
+    if(!file)
+    {
+        return NULL;
+    }
+    
+    //The font streams glyphs from the file, so count the file size
+    Sint64 size = SDL_RWsize(file);
+    *bytes = size > 0 ? (size_t)size : 1;
+    
+    //FreeType shares one library instance, so open fonts one at a time
+    SDL_AtomicLock(&fontLock);
+    TTF_Font *font = TTF_OpenFontRW(file, 1, ptSize);
+    SDL_AtomicUnlock(&fontLock);
+    return font;
+}
+#endif
+
+
+static void DecodeAsset(Asset *asset)
+{
+    //Do the slow part of a load, which is safe on any thread
+    size_t bytes = 0;
+    
+    switch(asset->type)
+    {
+    case ASSET_TEXTURE:
+        if((asset->pixels = LoadImageFile(asset->path, asset->param)))
+        {
+            asset->size.x = asset->pixels->w;
+            asset->size.y = asset->pixels->h;
+            
+            //Textures can only be created on the render thread
+            SDL_LockMutex(loadLock);
+            *uploadTail = asset;
+            uploadTail = &asset->queued;
+            SDL_UnlockMutex(loadLock);
+            return;
+        }
+        
+        break;
+        
+    case ASSET_SURFACE:
+        if((asset->data.surface = LoadImageFile(asset->path, asset->param)))
+        {
+            asset->size.x = asset->data.surface->w;
+            asset->size.y = asset->data.surface->h;
+            bytes = (size_t)asset->data.surface->pitch * asset->size.y;
+        }
+        
+        break;
+        
+    #ifdef USE_SDL_MIXER
+    case ASSET_SOUND:
+        if((asset->data.chunk = LoadPackedSound(asset->path)) || 
+            (asset->data.chunk = Mix_LoadWAV(asset->path)))
+        {
+            bytes = asset->data.chunk->alen;
+        }
+        
+        break;
+    #endif
+    
+    #ifdef USE_SDL_TTF
+    case ASSET_FONT:
+        asset->data.font = OpenFont(asset->path, asset->param, &bytes);
+        
+        if(!asset->data.font)
+        {
+            bytes = 0;
+        }
+        
+        break;
+    #endif
+    
+    default:
+        break;
+    }
+    
+    if(!bytes)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s: %s", asset->path, 
+            SDL_GetError());
+    }
+    
+    FinishAsset(asset, bytes);
+}
+
+
+static int SDLCALL LoaderThread(void *data)
+{
+    SDL_LockMutex(loadLock);
+    
+    while(loadQueue || loadersRunning)
+    {
+        //Wait for work
+        if(!loadQueue)
+        {
+            SDL_CondWait(loadCond, loadLock);
+            continue;
+        }
+        
+        Asset *asset = loadQueue;
+        loadQueue = asset->queued;
+        asset->queued = NULL;
+        
+        if(!loadQueue)
+        {
+            loadTail = &loadQueue;
+        }
+        
+        //Decode without holding the lock
+        SDL_UnlockMutex(loadLock);
+        DecodeAsset(asset);
+        SDL_LockMutex(loadLock);
+    }
+    
+    SDL_UnlockMutex(loadLock);
+    return 0;
+}
+
+
+static Asset *RequestAsset(AssetType type, const char *path, int param)
+{
+    Asset *asset = FindAsset(type, path, param);
+    
+    if(!asset)
+    {
+        if(!(asset = NewAsset(type, path, param)))
+        {
+            return NULL;
+        }
+        
+        if(loaderCount > 0)
+        {
+            //Hand the asset to the loader pool
+            SDL_LockMutex(loadLock);
+            *loadTail = asset;
+            loadTail = &asset->queued;
+            SDL_CondSignal(loadCond);
+            SDL_UnlockMutex(loadLock);
+        }
+        else
+        {
+            DecodeAsset(asset);
+        }
+    }
+    
+    return asset;
+}
+
+
+Asset *LoadTextureAsync(const char *path, int scale)
+{
+    return RequestAsset(ASSET_TEXTURE, path, scale);
+}
+
+
+Asset *LoadSurfaceAsync(const char *path, int scale)
+{
+    return RequestAsset(ASSET_SURFACE, path, scale);
+}
+
+
+#ifdef USE_SDL_MIXER
+Asset *LoadSoundAsync(const char *path)
+{
+    return RequestAsset(ASSET_SOUND, path, 0);
+}
+#endif
+
+
+#ifdef USE_SDL_TTF
+Asset *LoadFontAsync(const char *path, int ptSize)
+{
+    return RequestAsset(ASSET_FONT, path, ptSize);
+}
+#endif
+
+
+int IsAssetReady(const Asset *asset)
+{
+    return asset && 
+        SDL_AtomicGet((SDL_atomic_t*)&asset->state) == ASSET_READY;
+}
+
+
+int WaitForAsset(Asset *asset)
+{
+    //Keep uploading textures while we wait so the asset can't stall
+    while(asset && SDL_AtomicGet(&asset->state) == ASSET_PENDING)
+    {
+        if(!ProcessAssetUploads(0))
+        {
+            SDL_Delay(1);
+        }
+    }
+    
+    return IsAssetReady(asset);
+}
+
+
+int ProcessAssetUploads(int maxUploads)
+{
+    //Create textures for decoded images (render thread only)
+    int uploads = 0;
+    
+    while(!maxUploads || uploads < maxUploads)
+    {
+        SDL_LockMutex(loadLock);
+        Asset *asset = uploadQueue;
+        
+        if(asset)
+        {
+            uploadQueue = asset->queued;
+            asset->queued = NULL;
+            
+            if(!uploadQueue)
+            {
+                uploadTail = &uploadQueue;
+            }
+        }
+        
+        SDL_UnlockMutex(loadLock);
+        
+        if(!asset)
+        {
+            break;
+        }
+        
+        asset->data.tex = CreateImageTexture(cacheRenderer, asset->pixels);
+        SDL_FreeSurface(asset->pixels);
+        asset->pixels = NULL;
+        
+        if(!asset->data.tex)
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+        }
+        
+        FinishAsset(asset, asset->data.tex ? 
+            (size_t)asset->size.x * asset->size.y * 4 : 0);
+        uploads++;
+    }
+    
+    return uploads;
+}
+
+
+void ReleaseAsset(Asset *asset)
+{
+    if(!asset || --asset->refs > 0)
+    {
+        return;
+    }
+    
+    //A loader may still be working on it
+    WaitForAsset(asset);
+    
+    //Unlink the asset and free it once the last reference is gone
+    for(Asset **link = &assets; *link; link = &(*link)->next)
+    {
+        if(*link == asset)
+        {
+            *link = asset->next;
+            break;
+        }
+    }
+    
+    UnloadAsset(asset);
+}
+
+
+size_t GetAssetMemory(void)
+{
+    return (size_t)SDL_AtomicGet(&assetMemory);
+}
@@ -0,0 +1,86 @@
+/*
+SDL2 Asset Cache
+*/
+
+#ifndef ASSETS_H
+#define ASSETS_H
+
+#include <SDL2/SDL.h>
+
+#ifdef USE_SDL_MIXER
+#include <SDL2/SDL_mixer.h>
+#endif
+
+#ifdef USE_SDL_TTF
+#include <SDL2/SDL_ttf.h>
+#endif
+
+
+//Types
+//===========================================================================
+typedef enum
+{
+    ASSET_TEXTURE,
+    ASSET_SURFACE,      //decoded image kept in system memory
+    ASSET_SOUND,
+    ASSET_FONT
+} AssetType;
+
+
+typedef enum
+{
+    ASSET_PENDING,
+    ASSET_READY,
+    ASSET_FAILED
+} AssetState;
+
+
+typedef struct Asset
+{
+    AssetType type;
+    char *path;
+    int param;          //point size for fonts, scale in percent for images
+    int refs;
+    SDL_atomic_t state;
+    size_t bytes;       //approximate memory used
+    SDL_Point size;     //image size
+    SDL_Surface *pixels; //decoded image waiting to be uploaded
+    union
+    {
+        SDL_Texture *tex;
+        SDL_Surface *surface;
+        #ifdef USE_SDL_MIXER
+        Mix_Chunk *chunk;
+        #endif
+        #ifdef USE_SDL_TTF
+        TTF_Font *font;
+        #endif
+    } data;
+    struct Asset *next;
+    struct Asset *queued;
+} Asset;
+
+
+//Functions
+//===========================================================================
+void InitAssetCache(SDL_Renderer *renderer);
+void FreeAssetCache(void);
+int OpenAssetPack(const char *filename);
+Asset *LoadTextureAsync(const char *path, int scale);
+Asset *LoadSurfaceAsync(const char *path, int scale);
+
+#ifdef USE_SDL_MIXER
+Asset *LoadSoundAsync(const char *path);
+#endif
+
+#ifdef USE_SDL_TTF
+Asset *LoadFontAsync(const char *path, int ptSize);
+#endif
+
+int IsAssetReady(const Asset *asset);
+int WaitForAsset(Asset *asset);
+int ProcessAssetUploads(int maxUploads);
+void ReleaseAsset(Asset *asset);
+size_t GetAssetMemory(void);
+
+#endif
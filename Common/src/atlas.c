@@ -0,0 +1,195 @@
+/*
+SDL2 Sprite Atlas
+*/
+
+#include "assets.h"
+#include "atlas.h"
+#include "pixels.h"
+
+
+//Macros
+//===========================================================================
+#define ATLAS_PADDING 1 //empty pixels between regions to avoid bleeding
+
+
+//Functions
+//===========================================================================
+static int PackRegions(Atlas *atlas, SDL_Surface **images, int width)
+{
+    //Place the images on shelves from tallest to shortest
+    int order[MAX_ATLAS_REGIONS];
+    
+    for(int i = 0; i < atlas->count; i++)
+    {
+        order[i] = i;
+    }
+    
+    for(int i = 1; i < atlas->count; i++)
+    {
+        for(int j = i; j > 0 && images[order[j]]->h > images[order[j - 1]]->h; 
+            j--)
+        {
+            int tmp = order[j];
+            order[j] = order[j - 1];
+            order[j - 1] = tmp;
+        }
+    }
+    
+    int x = 0;
+    int y = 0;
+    int shelfHeight = 0;
+    
+    for(int i = 0; i < atlas->count; i++)
+    {
+        SDL_Surface *img = images[order[i]];
+        SDL_Rect *rect = &atlas->regions[order[i]].rect;
+        
+        //Start a new shelf if this image doesn't fit on the current one
+        if(x + img->w > width)
+        {
+            x = 0;
+            y += shelfHeight + ATLAS_PADDING;
+            shelfHeight = 0;
+        }
+        
+        rect->x = x;
+        rect->y = y;
+        rect->w = img->w;
+        rect->h = img->h;
+        x += img->w + ATLAS_PADDING;
+        shelfHeight = SDL_max(shelfHeight, img->h);
+    }
+    
+    //Return the total height
+    return y + shelfHeight;
+}
+
+
+static int UploadAtlas(Atlas *atlas, SDL_Renderer *renderer, 
+    SDL_Surface **images)
+{
+    //Pick a power of 2 width that makes the atlas roughly square
+    int area = 0;
+    int widest = 0;
+    
+    for(int i = 0; i < atlas->count; i++)
+    {
+        area += (images[i]->w + ATLAS_PADDING) * 
+            (images[i]->h + ATLAS_PADDING);
+        widest = SDL_max(widest, images[i]->w);
+    }
+    
+    int width = 64;
+    
+    while(width < widest || width * width < area)
+    {
+        width *= 2;
+    }
+    
+    atlas->size.x = width;
+    atlas->size.y = PackRegions(atlas, images, width);
+    
+    //Copy every image into one surface in the native format
+    SDL_Surface *sheet = SDL_CreateRGBSurfaceWithFormat(0, atlas->size.x, 
+        atlas->size.y, 32, GetNativePixelFormat());
+    
+    if(!sheet)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+        return 1;
+    }
+    
+    SDL_FillRect(sheet, NULL, 0);
+    
+    for(int i = 0; i < atlas->count; i++)
+    {
+        //Copy alpha as-is instead of blending it onto the empty sheet
+        SDL_SetSurfaceBlendMode(images[i], SDL_BLENDMODE_NONE);
+        SDL_BlitSurface(images[i], NULL, sheet, &atlas->regions[i].rect);
+    }
+    
+    //Upload the sheet as a single texture
+    atlas->tex = CreateImageTexture(renderer, sheet);
+    SDL_FreeSurface(sheet);
+    
+    if(!atlas->tex)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+        return 1;
+    }
+    
+    return 0;
+}
+
+
+int BuildAtlas(Atlas *atlas, SDL_Renderer *renderer, const char **filenames, 
+    int count, const int *scales, int scaleCount)
+{
+    SDL_memset(atlas, 0, sizeof(*atlas));
+    int total = count * scaleCount;
+    
+    if(total > MAX_ATLAS_REGIONS)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, 
+            "Too many atlas regions (%i > %i)", total, MAX_ATLAS_REGIONS);
+        return 1;
+    }
+    
+    //Decode and scale a copy of each image for every scale in parallel
+    Asset *assets[MAX_ATLAS_REGIONS];
+    
+    for(int i = 0; i < total; i++)
+    {
+        assets[i] = LoadSurfaceAsync(filenames[i % count], 
+            scales[i / count]);
+    }
+    
+    //The layout needs every image size, so wait for all of them
+    SDL_Surface *images[MAX_ATLAS_REGIONS];
+    int result = 0;
+    
+    for(atlas->count = 0; atlas->count < total; atlas->count++)
+    {
+        if(!WaitForAsset(assets[atlas->count]))
+        {
+            result = 1;
+            break;
+        }
+        
+        images[atlas->count] = assets[atlas->count]->data.surface;
+        atlas->regions[atlas->count].name = filenames[atlas->count % count];
+        atlas->regions[atlas->count].scale = scales[atlas->count / count];
+    }
+    
+    //Pack them into a single texture
+    if(!result)
+    {
+        result = UploadAtlas(atlas, renderer, images);
+    }
+    
+    //Release the source images
+    for(int i = 0; i < total; i++)
+    {
+        ReleaseAsset(assets[i]);
+    }
+    
+    return result;
+}
+
+
+const SDL_Rect *FindAtlasRegion(const Atlas *atlas, const char *filename, 
+    int scale)
+{
+    //Look up a region by the name of the image it was loaded from and the
+    //scale it was resampled to
+    for(int i = 0; i < atlas->count; i++)
+    {
+        if(atlas->regions[i].scale == scale && 
+            SDL_strcmp(atlas->regions[i].name, filename) == 0)
+        {
+            return &atlas->regions[i].rect;
+        }
+    }
+    
+    return NULL;
+}
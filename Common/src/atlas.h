@@ -0,0 +1,42 @@
+/*
+SDL2 Sprite Atlas
+*/
+
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#include <SDL2/SDL.h>
+
+
+//Macros
+//===========================================================================
+#define MAX_ATLAS_REGIONS 32
+
+
+//Types
+//===========================================================================
+typedef struct
+{
+    const char *name; //image the region was loaded from
+    int scale;        //size of this copy in percent of the image size
+    SDL_Rect rect;    //where the image lives in the atlas texture
+} AtlasRegion;
+
+
+typedef struct
+{
+    SDL_Texture *tex;
+    SDL_Point size;
+    AtlasRegion regions[MAX_ATLAS_REGIONS];
+    int count;
+} Atlas;
+
+
+//Functions
+//===========================================================================
+int BuildAtlas(Atlas *atlas, SDL_Renderer *renderer, const char **filenames, 
+    int count, const int *scales, int scaleCount);
+const SDL_Rect *FindAtlasRegion(const Atlas *atlas, const char *filename, 
+    int scale);
+
+#endif
@@ -0,0 +1,256 @@
+/*
+SDL2 Audio Output
+*/
+
+#include "audio.h"
+#include "mixer.h"
+#include "telemetry.h"
+
+
+//Globals
+//===========================================================================
+static int frameSize = 0;       //bytes per sample frame
+static double freqPerFrame = 0; //performance counter ticks per frame
+static double msPerTick = 0;
+static Uint64 lastMix = 0;
+static SDL_atomic_t mixCount;
+static SDL_atomic_t underruns;
+static SDL_atomic_t bufferSamples;
+static SDL_atomic_t playPending;
+static Uint64 playTime = 0;
+static int softMixer = 0;
+static int chunkFrameSize = 0;  //bytes per frame of a decoded sound
+
+
+//Functions
+//===========================================================================
+static void SDLCALL WatchOutput(void *data, Uint8 *stream, int len)
+{
+    //SDL doesn't tell us when the device runs dry, but if the mixer is
+    //called more than a whole buffer late the device had nothing to play
+    Uint64 now = SDL_GetPerformanceCounter();
+    int samples = len / frameSize;
+    double period = samples * freqPerFrame;
+    
+    if(lastMix && now - lastMix > period * 2)
+    {
+        SDL_AtomicAdd(&underruns, 1);
+        RecordTelemetry(TELEMETRY_AUDIO_UNDERRUN, 
+            (float)((now - lastMix) * msPerTick));
+    }
+    
+    lastMix = now;
+    SDL_AtomicSet(&bufferSamples, samples);
+    SDL_AtomicAdd(&mixCount, 1);
+    
+    //A sound started since the last call was just mixed into this buffer,
+    //which plays once the one queued before it is done
+    if(SDL_AtomicGet(&playPending))
+    {
+        RecordTelemetry(TELEMETRY_AUDIO_LATENCY, 
+            (float)((now - playTime + period) * msPerTick));
+        SDL_AtomicSet(&playPending, 0);
+    }
+}
+
+
+static int SDLCALL ReadMusic(void *data, Uint8 *dest, int len)
+{
+    return ReadSoundStream((SoundStream*)data, dest, len);
+}
+
+
+static void SDLCALL HookMusic(void *data, Uint8 *stream, int len)
+{
+    //SDL_mixer clears the buffer first, so whatever isn't ready stays silent
+    ReadSoundStream((SoundStream*)data, stream, len);
+}
+
+
+static int OpenMixer(int rate, int channels, int samples)
+{
+    if(Mix_OpenAudio(rate, MIX_DEFAULT_FORMAT, channels, samples) == -1)
+    {
+        return 1;
+    }
+    
+    //Watch what the device actually asks for
+    int freq;
+    Uint16 format;
+    Mix_QuerySpec(&freq, &format, &channels);
+    frameSize = SDL_AUDIO_BITSIZE(format) / 8 * channels;
+    freqPerFrame = (double)SDL_GetPerformanceFrequency() / freq;
+    msPerTick = 1000.0 / SDL_GetPerformanceFrequency();
+    lastMix = 0;
+    SDL_AtomicSet(&mixCount, 0);
+    SDL_AtomicSet(&underruns, 0);
+    SDL_AtomicSet(&bufferSamples, samples);
+    SDL_AtomicSet(&playPending, 0);
+    Mix_SetPostMix(&WatchOutput, NULL);
+    return 0;
+}
+
+
+static int ProbeAudio(int rate, int channels)
+{
+    //Try ever larger buffers until one plays for a while without running
+    //dry. Silence costs the device as much as sound does. This takes a
+    //moment per size, so it is only done when asked for.
+    for(int samples = AUDIO_PROBE_MIN; samples < AUDIO_PROBE_MAX; 
+        samples *= 2)
+    {
+        //The device may just not take this size
+        if(OpenMixer(rate, channels, samples))
+        {
+            continue;
+        }
+        
+        SDL_Delay(AUDIO_PROBE_MS);
+        
+        if(SDL_AtomicGet(&mixCount) > 1 && !SDL_AtomicGet(&underruns))
+        {
+            return 0;
+        }
+        
+        CloseAudio();
+    }
+    
+    return OpenMixer(rate, channels, AUDIO_PROBE_MAX);
+}
+
+
+static void StartSoftMixer(void)
+{
+    //SDL_mixer stays open to decode sounds in its format, but its device
+    //only ever plays silence
+    int freq;
+    Uint16 format;
+    int channels;
+    Mix_QuerySpec(&freq, &format, &channels);
+    int samples = SDL_AtomicGet(&bufferSamples);
+    
+    if(format != AUDIO_S16SYS)
+    {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "%s", 
+            "The software mixer only plays 16-bit sounds.");
+        return;
+    }
+    
+    Mix_SetPostMix(NULL, NULL);
+    chunkFrameSize = (int)sizeof(Sint16) * channels;
+    frameSize = (int)sizeof(float) * channels;
+    lastMix = 0;
+    
+    if(OpenSoftMixer(freq, channels, samples, &WatchOutput))
+    {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+        frameSize = SDL_AUDIO_BITSIZE(format) / 8 * channels;
+        Mix_SetPostMix(&WatchOutput, NULL);
+        return;
+    }
+    
+    softMixer = 1;
+    SDL_Log("%s", "Mixing audio in software");
+}
+
+
+int OpenAudio(int rate, int channels, int samples, int soft)
+{
+    //0 means the default, and a probe looks for the smallest buffer that
+    //keeps up
+    rate = rate > 0 ? rate : MIX_DEFAULT_FREQUENCY;
+    channels = channels > 0 ? channels : MIX_DEFAULT_CHANNELS;
+    samples = samples ? samples : AUDIO_BUFFER;
+    
+    if(samples == AUDIO_PROBE ? ProbeAudio(rate, channels) : 
+        OpenMixer(rate, channels, samples))
+    {
+        return 1;
+    }
+    
+    int freq;
+    Uint16 format;
+    Mix_QuerySpec(&freq, &format, &channels);
+    samples = SDL_AtomicGet(&bufferSamples);
+    SDL_Log("Audio: %i Hz, %i channels, %i sample buffer (%.1f ms)", freq, 
+        channels, samples, samples * 1000.0 / freq);
+    
+    //Move playback to our own mixer if asked to
+    if(soft)
+    {
+        StartSoftMixer();
+    }
+    
+    return 0;
+}
+
+
+void CloseAudio(void)
+{
+    CloseSoftMixer();
+    softMixer = 0;
+    Mix_SetPostMix(NULL, NULL);
+    Mix_CloseAudio();
+}
+
+
+int AllocateVoices(int count)
+{
+    return softMixer ? SDL_min(count, MIXER_VOICES) : 
+        Mix_AllocateChannels(count);
+}
+
+
+int PlayAudioChunk(int voice, Mix_Chunk *chunk, int volume)
+{
+    //Note when the first sound since the last mix was started, so the
+    //mixer can tell how long it takes to be heard
+    if(!SDL_AtomicGet(&playPending))
+    {
+        playTime = SDL_GetPerformanceCounter();
+        SDL_AtomicSet(&playPending, 1);
+    }
+    
+    if(softMixer)
+    {
+        return PlaySoftVoice(voice, (const Sint16*)chunk->abuf, 
+            (int)(chunk->alen / chunkFrameSize), 
+            (float)volume / MIX_MAX_VOLUME);
+    }
+    
+    Mix_Volume(voice, volume);
+    return Mix_PlayChannel(voice, chunk, 0);
+}
+
+
+void StopVoice(int voice)
+{
+    if(softMixer)
+    {
+        StopSoftVoice(voice);
+    }
+    else
+    {
+        Mix_HaltChannel(voice);
+    }
+}
+
+
+int IsVoicePlaying(int voice)
+{
+    return softMixer ? IsSoftVoicePlaying(voice) : Mix_Playing(voice);
+}
+
+
+void PlayAudioStream(SoundStream *stream)
+{
+    //The stream has to stay open until the audio is closed
+    if(softMixer)
+    {
+        SetSoftMusic(&ReadMusic, stream);
+    }
+    else
+    {
+        Mix_HookMusic(&HookMusic, stream);
+    }
+}
@@ -0,0 +1,32 @@
+/*
+SDL2 Audio Output
+*/
+
+#ifndef AUDIO_H
+#define AUDIO_H
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_mixer.h>
+#include "stream.h"
+
+
+//Macros
+//===========================================================================
+#define AUDIO_BUFFER     4096 //samples per buffer unless told otherwise
+#define AUDIO_PROBE      -1   //find the smallest buffer that keeps up
+#define AUDIO_PROBE_MIN  256  //smallest buffer the probe tries
+#define AUDIO_PROBE_MAX  4096 //largest buffer, also used if nothing else works
+#define AUDIO_PROBE_MS   250  //how long each buffer size is listened to
+
+
+//Functions
+//===========================================================================
+int OpenAudio(int rate, int channels, int samples, int soft);
+void CloseAudio(void);
+int AllocateVoices(int count);
+int PlayAudioChunk(int voice, Mix_Chunk *chunk, int volume);
+void StopVoice(int voice);
+int IsVoicePlaying(int voice);
+void PlayAudioStream(SoundStream *stream);
+
+#endif
@@ -0,0 +1,174 @@
+/*
+SDL2 Sprite Batch
+*/
+
+#include "batch.h"
+
+
+//Functions
+//===========================================================================
+int InitSpriteBatch(SpriteBatch *batch, SDL_Renderer *renderer)
+{
+    SDL_memset(batch, 0, sizeof(*batch));
+    batch->renderer = renderer;
+    
+    #ifdef USE_RENDER_GEOMETRY
+    batch->vertices = (SDL_Vertex*)SDL_malloc(SPRITE_BATCH_SIZE * 4 * 
+        sizeof(SDL_Vertex));
+    batch->indices = (int*)SDL_malloc(SPRITE_BATCH_SIZE * 6 * sizeof(int));
+    
+    if(!batch->vertices || !batch->indices)
+    {
+        FreeSpriteBatch(batch);
+        SDL_OutOfMemory();
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+        return 1;
+    }
+    
+    //Every sprite is two triangles over its 4 corners
+    for(int i = 0; i < SPRITE_BATCH_SIZE; i++)
+    {
+        int *index = batch->indices + i * 6;
+        index[0] = i * 4;
+        index[1] = i * 4 + 1;
+        index[2] = i * 4 + 2;
+        index[3] = i * 4 + 2;
+        index[4] = i * 4 + 1;
+        index[5] = i * 4 + 3;
+    }
+    #else
+    batch->srcRects = (SDL_Rect*)SDL_malloc(SPRITE_BATCH_SIZE * 
+        sizeof(SDL_Rect));
+    batch->dstRects = (SDL_Rect*)SDL_malloc(SPRITE_BATCH_SIZE * 
+        sizeof(SDL_Rect));
+    batch->colors = (SDL_Color*)SDL_malloc(SPRITE_BATCH_SIZE * 
+        sizeof(SDL_Color));
+        
+    if(!batch->srcRects || !batch->dstRects || !batch->colors)
+    {
+        FreeSpriteBatch(batch);
+        SDL_OutOfMemory();
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+        return 1;
+    }
+    #endif
+    
+    return 0;
+}
+
+
+void FreeSpriteBatch(SpriteBatch *batch)
+{
+    #ifdef USE_RENDER_GEOMETRY
+    SDL_free(batch->vertices);
+    SDL_free(batch->indices);
+    #else
+    SDL_free(batch->srcRects);
+    SDL_free(batch->dstRects);
+    SDL_free(batch->colors);
+    #endif
+    
+    SDL_memset(batch, 0, sizeof(*batch));
+}
+
+
+void DrawSprite(SpriteBatch *batch, SDL_Texture *tex, const SDL_Rect *src, 
+    const SDL_Rect *dst, SDL_Color color)
+{
+    //Sprites are drawn in order, so switching textures starts a new batch
+    if(tex != batch->tex)
+    {
+        FlushSpriteBatch(batch);
+        batch->tex = tex;
+        batch->texSize.x = 1;
+        batch->texSize.y = 1;
+        SDL_QueryTexture(tex, NULL, NULL, &batch->texSize.x, 
+            &batch->texSize.y);
+    }
+    else if(batch->count == SPRITE_BATCH_SIZE)
+    {
+        FlushSpriteBatch(batch);
+    }
+    
+    //NULL rects mean the whole texture and the whole render target
+    SDL_Rect whole = {0, 0, batch->texSize.x, batch->texSize.y};
+    SDL_Rect screen = {0, 0, 0, 0};
+    
+    if(!src)
+    {
+        src = &whole;
+    }
+    
+    if(!dst)
+    {
+        SDL_GetRendererOutputSize(batch->renderer, &screen.w, &screen.h);
+        dst = &screen;
+    }
+    
+    #ifdef USE_RENDER_GEOMETRY
+    //Add the 4 corners of the sprite
+    SDL_Vertex *vertex = batch->vertices + batch->count * 4;
+    float u0 = (float)src->x / batch->texSize.x;
+    float v0 = (float)src->y / batch->texSize.y;
+    float u1 = (float)(src->x + src->w) / batch->texSize.x;
+    float v1 = (float)(src->y + src->h) / batch->texSize.y;
+    
+    for(int i = 0; i < 4; i++)
+    {
+        vertex[i].position.x = (float)(i & 1 ? dst->x + dst->w : dst->x);
+        vertex[i].position.y = (float)(i & 2 ? dst->y + dst->h : dst->y);
+        vertex[i].color = color;
+        vertex[i].tex_coord.x = i & 1 ? u1 : u0;
+        vertex[i].tex_coord.y = i & 2 ? v1 : v0;
+    }
+    #else
+    batch->srcRects[batch->count] = *src;
+    batch->dstRects[batch->count] = *dst;
+    batch->colors[batch->count] = color;
+    #endif
+    
+    batch->count++;
+}
+
+
+void FlushSpriteBatch(SpriteBatch *batch)
+{
+    if(!batch->count)
+    {
+        return;
+    }
+    
+    #ifdef USE_RENDER_GEOMETRY
+    //Submit every sprite with one call
+    SDL_RenderGeometry(batch->renderer, batch->tex, batch->vertices, 
+        batch->count * 4, batch->indices, batch->count * 6);
+    #else
+    //Copy one sprite at a time, only changing the texture color when needed
+    SDL_Color current = {255, 255, 255, 255};
+    
+    for(int i = 0; i < batch->count; i++)
+    {
+        SDL_Color color = batch->colors[i];
+        
+        if(color.r != current.r || color.g != current.g || 
+            color.b != current.b || color.a != current.a)
+        {
+            SDL_SetTextureColorMod(batch->tex, color.r, color.g, color.b);
+            SDL_SetTextureAlphaMod(batch->tex, color.a);
+            current = color;
+        }
+        
+        SDL_RenderCopy(batch->renderer, batch->tex, &batch->srcRects[i], 
+            &batch->dstRects[i]);
+    }
+    
+    if(current.r != 255 || current.g != 255 || current.b != 255 || 
+        current.a != 255)
+    {
+        SDL_SetTextureColorMod(batch->tex, 255, 255, 255);
+        SDL_SetTextureAlphaMod(batch->tex, 255);
+    }
+    #endif
+    
+    batch->count = 0;
+}
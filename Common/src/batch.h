@@ -0,0 +1,51 @@
+/*
+SDL2 Sprite Batch
+*/
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <SDL2/SDL.h>
+
+
+//Macros
+//===========================================================================
+#define SPRITE_BATCH_SIZE 1024 //sprites per flush
+
+//SDL_RenderGeometry was added in SDL 2.0.18. Older versions draw the
+//batch with one SDL_RenderCopy per sprite, which SDL still queues up and
+//submits together.
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    #define USE_RENDER_GEOMETRY
+#endif
+
+
+//Types
+//===========================================================================
+typedef struct
+{
+    SDL_Renderer *renderer;
+    SDL_Texture *tex;    //texture of the sprites waiting to be drawn
+    SDL_Point texSize;   //for converting pixels to texture coordinates
+    int count;
+    
+    #ifdef USE_RENDER_GEOMETRY
+    SDL_Vertex *vertices;
+    int *indices;
+    #else
+    SDL_Rect *srcRects;
+    SDL_Rect *dstRects;
+    SDL_Color *colors;
+    #endif
+} SpriteBatch;
+
+
+//Functions
+//===========================================================================
+int InitSpriteBatch(SpriteBatch *batch, SDL_Renderer *renderer);
+void FreeSpriteBatch(SpriteBatch *batch);
+void DrawSprite(SpriteBatch *batch, SDL_Texture *tex, const SDL_Rect *src, 
+    const SDL_Rect *dst, SDL_Color color);
+void FlushSpriteBatch(SpriteBatch *batch);
+
+#endif
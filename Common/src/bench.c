@@ -0,0 +1,54 @@
+/*
+SDL2 Benchmark Mode
+*/
+
+#include <stdio.h>
+
+#include "bench.h"
+#include "telemetry.h"
+
+
+//Globals
+//===========================================================================
+static Uint64 benchStart = 0;
+
+
+//Functions
+//===========================================================================
+void PrepareBenchMode(void)
+{
+    //Must be called before SDL_Init. Benchmarks run without a display, GPU
+    //or sound card, so use the dummy drivers and the software renderer.
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+    SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+    SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
+    SDL_SetHint(SDL_HINT_RENDER_VSYNC, "0");
+}
+
+
+void StartBenchClock(void)
+{
+    benchStart = SDL_GetPerformanceCounter();
+}
+
+
+void PrintBenchReport(const char *name, int frames)
+{
+    //Calculate throughput
+    double seconds = (double)(SDL_GetPerformanceCounter() - benchStart) / 
+        SDL_GetPerformanceFrequency();
+    double fps = seconds > 0 ? frames / seconds : 0;
+    
+    //Frame time distribution (covers the most recent TELEMETRY_CAPACITY 
+    //frames)
+    TelemetryStats stats;
+    GetTelemetryStats(TELEMETRY_FRAME, &stats);
+    
+    //Print a single JSON line to stdout so scripts can parse it
+    printf("{\"app\": \"%s\", \"frames\": %d, \"seconds\": %.3f, "
+        "\"fps\": %.1f, \"mean_ms\": %.3f, \"p50_ms\": %.3f, "
+        "\"p95_ms\": %.3f, \"p99_ms\": %.3f, \"max_ms\": %.3f}\n", name, 
+        frames, seconds, fps, stats.mean, stats.p50, stats.p95, stats.p99, 
+        stats.max);
+    fflush(stdout);
+}
@@ -0,0 +1,17 @@
+/*
+SDL2 Benchmark Mode
+*/
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <SDL2/SDL.h>
+
+
+//Functions
+//===========================================================================
+void PrepareBenchMode(void);
+void StartBenchClock(void);
+void PrintBenchReport(const char *name, int frames);
+
+#endif
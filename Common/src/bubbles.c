@@ -0,0 +1,382 @@
+/*
+SDL2 Bubble Store
+*/
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include "bubbles.h"
+#include "jobs.h"
+
+
+//Macros
+//===========================================================================
+#define MOVE_GRAIN 4096 //bubbles per job, a multiple of every SIMD width
+
+
+//Types
+//===========================================================================
+typedef int (*MoveKernel)(float *pos, float *prev, float *vel, int count, 
+    float max);
+
+
+typedef struct
+{
+    BubbleStore *store;
+    MoveKernel kernel;
+    float maxX;
+    float maxY;
+} MoveJob;
+
+
+//Functions
+//===========================================================================
+static int GrowArray(void *array, size_t size)
+{
+    //The old array stays valid if we run out of memory
+    void **pointer = (void**)array;
+    void *mem = SDL_SIMDRealloc(*pointer, size);
+    
+    if(!mem)
+    {
+        return 1;
+    }
+    
+    *pointer = mem;
+    return 0;
+}
+
+
+static int GrowBubbleStore(BubbleStore *store, int capacity)
+{
+    //Make room in every array
+    if(GrowArray(&store->x, capacity * sizeof(float)) || 
+        GrowArray(&store->y, capacity * sizeof(float)) || 
+        GrowArray(&store->prevX, capacity * sizeof(float)) || 
+        GrowArray(&store->prevY, capacity * sizeof(float)) || 
+        GrowArray(&store->vx, capacity * sizeof(float)) || 
+        GrowArray(&store->vy, capacity * sizeof(float)) || 
+        GrowArray(&store->hp, capacity * sizeof(int)) || 
+        GrowArray(&store->state, capacity))
+    {
+        SDL_OutOfMemory();
+        return 1;
+    }
+    
+    store->capacity = capacity;
+    return 0;
+}
+
+
+static int ReserveBubbles(BubbleStore *store, int count)
+{
+    if(count <= store->capacity)
+    {
+        return 0;
+    }
+    
+    if(count > store->limit)
+    {
+        return 1;
+    }
+    
+    //Double the capacity so adding bubbles one at a time stays cheap
+    int capacity = SDL_max(store->capacity * 2, BUBBLE_BLOCK);
+    return GrowBubbleStore(store, SDL_min(SDL_max(capacity, count), 
+        store->limit));
+}
+
+
+int InitBubbleStore(BubbleStore *store, int limit)
+{
+    SDL_memset(store, 0, sizeof(*store));
+    store->limit = limit;
+    
+    if(GrowBubbleStore(store, SDL_min(limit, BUBBLE_BLOCK)))
+    {
+        FreeBubbleStore(store);
+        return 1;
+    }
+    
+    return 0;
+}
+
+
+void FreeBubbleStore(BubbleStore *store)
+{
+    SDL_SIMDFree(store->x);
+    SDL_SIMDFree(store->y);
+    SDL_SIMDFree(store->prevX);
+    SDL_SIMDFree(store->prevY);
+    SDL_SIMDFree(store->vx);
+    SDL_SIMDFree(store->vy);
+    SDL_SIMDFree(store->hp);
+    SDL_SIMDFree(store->state);
+    SDL_memset(store, 0, sizeof(*store));
+}
+
+
+int AddBubble(BubbleStore *store, float x, float y, float vx, float vy, 
+    int hp)
+{
+    //New bubbles go on the end
+    if(ReserveBubbles(store, store->count + 1))
+    {
+        return -1;
+    }
+    
+    int i = store->count++;
+    store->x[i] = x;
+    store->y[i] = y;
+    store->prevX[i] = x;
+    store->prevY[i] = y;
+    store->vx[i] = vx;
+    store->vy[i] = vy;
+    store->hp[i] = hp;
+    store->state[i] = BUBBLE_ACTIVE;
+    return i;
+}
+
+
+void RemoveBubble(BubbleStore *store, int i)
+{
+    //Fill the hole with the last bubble
+    int last = --store->count;
+    store->x[i] = store->x[last];
+    store->y[i] = store->y[last];
+    store->prevX[i] = store->prevX[last];
+    store->prevY[i] = store->prevY[last];
+    store->vx[i] = store->vx[last];
+    store->vy[i] = store->vy[last];
+    store->hp[i] = store->hp[last];
+    store->state[i] = store->state[last];
+}
+
+
+void BurstBubble(BubbleStore *store, int i, int frames)
+{
+    //Popped bubbles stay where they are until they disappear
+    store->vx[i] = 0;
+    store->vy[i] = 0;
+    store->hp[i] = frames;
+    store->state[i] = BUBBLE_POPPING;
+}
+
+
+//Each kernel moves one axis: it saves the old position, adds the velocity
+//and reverses the velocity of bubbles outside [0, max]. Popping bubbles
+//have no velocity, so they can go through the same math.
+static void MoveAxis(float *pos, float *prev, float *vel, int count, 
+    float max)
+{
+    for(int i = 0; i < count; i++)
+    {
+        prev[i] = pos[i];
+        pos[i] += vel[i];
+        
+        if(pos[i] < 0 || pos[i] > max)
+        {
+            vel[i] = -vel[i];
+        }
+    }
+}
+
+
+#ifdef __SSE2__
+static int MoveAxisSSE2(float *pos, float *prev, float *vel, int count, 
+    float max)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 limit = _mm_set1_ps(max);
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    int i = 0;
+    
+    for(; i + 4 <= count; i += 4)
+    {
+        __m128 p = _mm_load_ps(pos + i);
+        __m128 v = _mm_load_ps(vel + i);
+        _mm_store_ps(prev + i, p);
+        p = _mm_add_ps(p, v);
+        
+        //Flip the sign bit of the velocities that are out of bounds
+        __m128 out = _mm_or_ps(_mm_cmplt_ps(p, zero), _mm_cmpgt_ps(p, limit));
+        _mm_store_ps(pos + i, p);
+        _mm_store_ps(vel + i, _mm_xor_ps(v, _mm_and_ps(out, sign)));
+    }
+    
+    return i;
+}
+#endif
+
+
+#ifdef __AVX2__
+static int MoveAxisAVX2(float *pos, float *prev, float *vel, int count, 
+    float max)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 limit = _mm256_set1_ps(max);
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    int i = 0;
+    
+    for(; i + 8 <= count; i += 8)
+    {
+        __m256 p = _mm256_loadu_ps(pos + i);
+        __m256 v = _mm256_loadu_ps(vel + i);
+        _mm256_storeu_ps(prev + i, p);
+        p = _mm256_add_ps(p, v);
+        
+        //Flip the sign bit of the velocities that are out of bounds
+        __m256 out = _mm256_or_ps(_mm256_cmp_ps(p, zero, _CMP_LT_OQ), 
+            _mm256_cmp_ps(p, limit, _CMP_GT_OQ));
+        _mm256_storeu_ps(pos + i, p);
+        _mm256_storeu_ps(vel + i, _mm256_xor_ps(v, _mm256_and_ps(out, sign)));
+    }
+    
+    return i;
+}
+#endif
+
+
+#ifdef __ARM_NEON
+static int MoveAxisNEON(float *pos, float *prev, float *vel, int count, 
+    float max)
+{
+    const float32x4_t zero = vdupq_n_f32(0);
+    const float32x4_t limit = vdupq_n_f32(max);
+    const uint32x4_t sign = vdupq_n_u32(0x80000000);
+    int i = 0;
+    
+    for(; i + 4 <= count; i += 4)
+    {
+        float32x4_t p = vld1q_f32(pos + i);
+        float32x4_t v = vld1q_f32(vel + i);
+        vst1q_f32(prev + i, p);
+        p = vaddq_f32(p, v);
+        
+        //Flip the sign bit of the velocities that are out of bounds
+        uint32x4_t out = vorrq_u32(vcltq_f32(p, zero), vcgtq_f32(p, limit));
+        vst1q_f32(pos + i, p);
+        vst1q_f32(vel + i, vreinterpretq_f32_u32(veorq_u32(
+            vreinterpretq_u32_f32(v), vandq_u32(out, sign))));
+    }
+    
+    return i;
+}
+#endif
+
+
+static void MoveBubbleRange(void *data, int start, int end)
+{
+    //Run the kernel over the range and finish each axis in C
+    const MoveJob *job = (const MoveJob*)data;
+    BubbleStore *store = job->store;
+    int count = end - start;
+    int done = job->kernel ? job->kernel(store->x + start, 
+        store->prevX + start, store->vx + start, count, job->maxX) : 0;
+    MoveAxis(store->x + start + done, store->prevX + start + done, 
+        store->vx + start + done, count - done, job->maxX);
+    done = job->kernel ? job->kernel(store->y + start, store->prevY + start, 
+        store->vy + start, count, job->maxY) : 0;
+    MoveAxis(store->y + start + done, store->prevY + start + done, 
+        store->vy + start + done, count - done, job->maxY);
+}
+
+
+void MoveBubbles(BubbleStore *store, float maxX, float maxY)
+{
+    //Pick the widest kernel the CPU supports
+    MoveJob job = {store, NULL, maxX, maxY};
+    
+    #ifdef __SSE2__
+    if(SDL_HasSSE2())
+    {
+        job.kernel = &MoveAxisSSE2;
+    }
+    #endif
+    
+    #ifdef __AVX2__
+    if(SDL_HasAVX2())
+    {
+        job.kernel = &MoveAxisAVX2;
+    }
+    #endif
+    
+    #ifdef __ARM_NEON
+    if(SDL_HasNEON())
+    {
+        job.kernel = &MoveAxisNEON;
+    }
+    #endif
+    
+    //Bubbles move independently, so split them across the job threads
+    ParallelFor(&MoveBubbleRange, &job, store->count, MOVE_GRAIN);
+    
+    //Count down the popped bubbles and remove the ones that are done. The
+    //bubble moved into a removed slot hasn't been counted down yet.
+    for(int i = 0; i < store->count;)
+    {
+        if(store->state[i] == BUBBLE_POPPING && --store->hp[i] == 0)
+        {
+            RemoveBubble(store, i);
+        }
+        else
+        {
+            i++;
+        }
+    }
+}
+
+
+void SnapshotBubbles(BubbleStore *dst, const BubbleStore *src)
+{
+    //Copy only what drawing needs, growing the copy to fit if we can
+    ReserveBubbles(dst, src->count);
+    int count = SDL_min(src->count, dst->capacity);
+    SDL_memcpy(dst->x, src->x, count * sizeof(float));
+    SDL_memcpy(dst->y, src->y, count * sizeof(float));
+    SDL_memcpy(dst->prevX, src->prevX, count * sizeof(float));
+    SDL_memcpy(dst->prevY, src->prevY, count * sizeof(float));
+    SDL_memcpy(dst->state, src->state, count);
+    dst->count = count;
+}
+
+
+static Uint32 HashWords(Uint32 hash, const void *data, int count)
+{
+    //32-bit FNV-1a, a word at a time since that is plenty to tell two runs
+    //apart
+    const Uint8 *bytes = (const Uint8*)data;
+    
+    for(int i = 0; i < count; i++)
+    {
+        Uint32 word;
+        SDL_memcpy(&word, bytes + i * 4, 4);
+        hash = (hash ^ word) * 16777619u;
+    }
+    
+    return hash;
+}
+
+
+Uint32 ChecksumBubbles(const BubbleStore *store, const Uint32 *extra, 
+    int words)
+{
+    //Hash the bubbles along with whatever other state the caller's next
+    //step depends on, so two runs only match if all of it is bit for bit
+    //the same
+    Uint32 hash = HashWords(2166136261u, extra, words);
+    hash = HashWords(hash, &store->count, 1);
+    hash = HashWords(hash, store->x, store->count);
+    hash = HashWords(hash, store->y, store->count);
+    hash = HashWords(hash, store->vx, store->count);
+    hash = HashWords(hash, store->vy, store->count);
+    hash = HashWords(hash, store->hp, store->count);
+    
+    for(int i = 0; i < store->count; i++)
+    {
+        hash = (hash ^ store->state[i]) * 16777619u;
+    }
+    
+    return hash;
+}
@@ -0,0 +1,59 @@
+/*
+SDL2 Bubble Store
+*/
+
+#ifndef BUBBLES_H
+#define BUBBLES_H
+
+#include <SDL2/SDL.h>
+
+
+//Macros
+//===========================================================================
+#define BUBBLE_BLOCK 64 //smallest number of bubbles to allocate room for
+
+
+//Types
+//===========================================================================
+typedef enum
+{
+    BUBBLE_ACTIVE,
+    BUBBLE_POPPING
+} BubbleState;
+
+
+//Every field lives in its own SIMD aligned array so the update can work on
+//several bubbles at once. Live bubbles are packed into the first count
+//slots: new ones go on the end and removed ones are replaced by the last,
+//so indices are only valid until the next removal. The arrays grow on
+//demand up to limit.
+typedef struct
+{
+    int limit;
+    int capacity;
+    int count;
+    float *x;
+    float *y;
+    float *prevX;   //position before the last step, for interpolation
+    float *prevY;
+    float *vx;
+    float *vy;
+    int *hp;        //hit points, or frames left to show the pop
+    Uint8 *state;
+} BubbleStore;
+
+
+//Functions
+//===========================================================================
+int InitBubbleStore(BubbleStore *store, int limit);
+void FreeBubbleStore(BubbleStore *store);
+int AddBubble(BubbleStore *store, float x, float y, float vx, float vy, 
+    int hp);
+void RemoveBubble(BubbleStore *store, int i);
+void BurstBubble(BubbleStore *store, int i, int frames);
+void MoveBubbles(BubbleStore *store, float maxX, float maxY);
+void SnapshotBubbles(BubbleStore *dst, const BubbleStore *src);
+Uint32 ChecksumBubbles(const BubbleStore *store, const Uint32 *extra, 
+    int words);
+
+#endif
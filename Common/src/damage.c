@@ -0,0 +1,155 @@
+/*
+SDL2 Damage Tracking
+*/
+
+#include "damage.h"
+
+
+//Functions
+//===========================================================================
+SDL_Renderer *CreateSurfaceRenderer(SDL_Window *window)
+{
+    //Render straight into the window surface, so pixels we don't redraw
+    //stay on screen from one frame to the next. Unlike a renderer made for
+    //one surface, this one moves to the new surface when the window is
+    //resized and keeps its textures.
+    return SDL_CreateRenderer(window, -1, SDL_RENDERER_SOFTWARE);
+}
+
+
+void InitDamageTracker(DamageTracker *damage, SDL_Window *window, 
+    SDL_Renderer *renderer, int enabled)
+{
+    SDL_memset(damage, 0, sizeof(*damage));
+    damage->window = window;
+    damage->renderer = renderer;
+    damage->enabled = enabled;
+    
+    //The first frame has to draw everything
+    DamageAll(damage);
+}
+
+
+void DamageAll(DamageTracker *damage)
+{
+    SDL_Rect *rect = &damage->rects[0];
+    rect->x = 0;
+    rect->y = 0;
+    SDL_GetRendererOutputSize(damage->renderer, &rect->w, &rect->h);
+    damage->count = 1;
+}
+
+
+void AddDamage(DamageTracker *damage, const SDL_Rect *rect)
+{
+    //Ignore anything outside the window
+    SDL_Rect screen = {0, 0, 0, 0};
+    SDL_Rect r;
+    SDL_GetRendererOutputSize(damage->renderer, &screen.w, &screen.h);
+    
+    if(!SDL_IntersectRect(rect, &screen, &r))
+    {
+        return;
+    }
+    
+    //Merge with every region it overlaps. The merged region can overlap
+    //regions we already checked, so start over after each merge.
+    for(int i = 0; i < damage->count;)
+    {
+        if(SDL_HasIntersection(&r, &damage->rects[i]))
+        {
+            SDL_UnionRect(&r, &damage->rects[i], &r);
+            damage->rects[i] = damage->rects[--damage->count];
+            i = 0;
+        }
+        else
+        {
+            i++;
+        }
+    }
+    
+    //Too many separate regions, so grow the last one instead
+    if(damage->count == MAX_DAMAGE_RECTS)
+    {
+        damage->count--;
+        SDL_UnionRect(&r, &damage->rects[damage->count], &r);
+    }
+    
+    damage->rects[damage->count++] = r;
+}
+
+
+void TrackDamage(DamageTracker *damage, int slot, const SDL_Rect *rect)
+{
+    //We can't remember where this sprite was, so redraw everything
+    if(slot < 0 || slot >= MAX_DAMAGE_SLOTS)
+    {
+        DamageAll(damage);
+        return;
+    }
+    
+    //A NULL rect means the sprite is hidden
+    SDL_Rect hidden = {0, 0, 0, 0};
+    SDL_Rect *last = &damage->slots[slot];
+    
+    if(!rect)
+    {
+        rect = &hidden;
+    }
+    
+    //Erase the old position and draw the new one if the sprite changed
+    if(!SDL_RectEquals(last, rect))
+    {
+        AddDamage(damage, last);
+        AddDamage(damage, rect);
+        *last = *rect;
+    }
+}
+
+
+int BeginDamageRect(DamageTracker *damage, int i)
+{
+    //Without damage tracking the whole window is a single region
+    if(!damage->enabled)
+    {
+        if(i == 0)
+        {
+            SDL_RenderClear(damage->renderer);
+            return 1;
+        }
+        
+        return 0;
+    }
+    
+    //Restore the clip rect once every region has been drawn
+    if(i >= damage->count)
+    {
+        SDL_RenderSetClipRect(damage->renderer, NULL);
+        return 0;
+    }
+    
+    //SDL_RenderClear ignores the clip rect, so fill the region instead
+    SDL_RenderSetClipRect(damage->renderer, &damage->rects[i]);
+    SDL_RenderFillRect(damage->renderer, &damage->rects[i]);
+    return 1;
+}
+
+
+void PresentDamage(DamageTracker *damage)
+{
+    if(!damage->enabled)
+    {
+        SDL_RenderPresent(damage->renderer);
+        return;
+    }
+    
+    //Finish the queued draws and copy only the damaged regions to the
+    //screen
+    if(damage->count)
+    {
+        SDL_RenderFlush(damage->renderer);
+        SDL_UpdateWindowSurfaceRects(damage->window, damage->rects, 
+            damage->count);
+        damage->count = 0;
+    }
+}
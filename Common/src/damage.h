@@ -0,0 +1,41 @@
+/*
+SDL2 Damage Tracking
+*/
+
+#ifndef DAMAGE_H
+#define DAMAGE_H
+
+#include <SDL2/SDL.h>
+
+
+//Macros
+//===========================================================================
+#define MAX_DAMAGE_SLOTS 64 //sprites whose last position is remembered
+#define MAX_DAMAGE_RECTS 16 //separate regions before they get merged
+
+
+//Types
+//===========================================================================
+typedef struct
+{
+    SDL_Window *window;
+    SDL_Renderer *renderer;
+    int enabled;                      //only redraw and present damage
+    int count;
+    SDL_Rect rects[MAX_DAMAGE_RECTS]; //regions to redraw this frame
+    SDL_Rect slots[MAX_DAMAGE_SLOTS]; //where each sprite was last drawn
+} DamageTracker;
+
+
+//Functions
+//===========================================================================
+SDL_Renderer *CreateSurfaceRenderer(SDL_Window *window);
+void InitDamageTracker(DamageTracker *damage, SDL_Window *window, 
+    SDL_Renderer *renderer, int enabled);
+void DamageAll(DamageTracker *damage);
+void AddDamage(DamageTracker *damage, const SDL_Rect *rect);
+void TrackDamage(DamageTracker *damage, int slot, const SDL_Rect *rect);
+int BeginDamageRect(DamageTracker *damage, int i);
+void PresentDamage(DamageTracker *damage);
+
+#endif
@@ -0,0 +1,128 @@
+/*
+SDL2 Batched Event Intake
+*/
+
+#include "events.h"
+
+
+//Macros
+//===========================================================================
+#define MAX_FILTER_TYPES 32
+
+
+//Globals
+//===========================================================================
+static Uint32 filterTypes[MAX_FILTER_TYPES];
+static int filterCount = 0;
+static Uint32 lastInputTime = 0;
+
+
+//Functions
+//===========================================================================
+static int SDLCALL FilterEvent(void *data, SDL_Event *event)
+{
+    //Remember when the newest mouse event arrived
+    switch(event->type)
+    {
+    case SDL_MOUSEMOTION:
+    case SDL_MOUSEBUTTONDOWN:
+    case SDL_MOUSEBUTTONUP:
+        lastInputTime = event->common.timestamp;
+        break;
+    }
+    
+    //Always let quit requests, app lifecycle events, and window and render
+    //events through. SDL runs the filter before its own event watches, so
+    //the renderer would otherwise never hear about resizes or lost devices.
+    if((event->type >= SDL_QUIT && 
+        event->type <= SDL_APP_DIDENTERFOREGROUND) || 
+        event->type == SDL_WINDOWEVENT || 
+        event->type == SDL_RENDER_TARGETS_RESET || 
+        event->type == SDL_RENDER_DEVICE_RESET)
+    {
+        return 1;
+    }
+    
+    //Only queue event types the app handles
+    for(int i = 0; i < filterCount; i++)
+    {
+        if(event->type == filterTypes[i])
+        {
+            return 1;
+        }
+    }
+    
+    return 0;
+}
+
+
+void InstallEventFilter(const Uint32 *types, int count)
+{
+    //Remember which event types to keep
+    filterCount = SDL_min(count, MAX_FILTER_TYPES);
+    SDL_memcpy(filterTypes, types, filterCount * sizeof(Uint32));
+    
+    //Drop unwanted events as they are pushed, and purge any that are 
+    //already queued
+    SDL_SetEventFilter(&FilterEvent, NULL);
+    SDL_FilterEvents(&FilterEvent, NULL);
+}
+
+
+int PollEventBatch(EventBatch *batch)
+{
+    batch->count = 0;
+    SDL_PumpEvents();
+    
+    //Drain the queue in chunks
+    while(batch->count < EVENT_BATCH_SIZE)
+    {
+        int start = batch->count;
+        int fetched = SDL_PeepEvents(&batch->events[start], 
+            EVENT_BATCH_SIZE - start, SDL_GETEVENT, SDL_FIRSTEVENT, 
+            SDL_LASTEVENT);
+        
+        if(fetched <= 0)
+        {
+            break;
+        }
+        
+        //Collapse each run of mouse motion events into its final event
+        int count = start;
+        
+        for(int i = start; i < start + fetched; i++)
+        {
+            SDL_Event *event = &batch->events[i];
+            
+            if(event->type == SDL_MOUSEMOTION)
+            {
+                //Merge into the previous event if it was also motion
+                SDL_Event *prev = count > 0 ? &batch->events[count - 1] : NULL;
+                
+                if(prev && prev->type == SDL_MOUSEMOTION && 
+                    prev->motion.which == event->motion.which)
+                {
+                    int xrel = prev->motion.xrel + event->motion.xrel;
+                    int yrel = prev->motion.yrel + event->motion.yrel;
+                    *prev = *event;
+                    prev->motion.xrel = xrel;
+                    prev->motion.yrel = yrel;
+                    continue;
+                }
+            }
+            
+            batch->events[count++] = *event;
+        }
+        
+        batch->count = count;
+    }
+    
+    return batch->count;
+}
+
+
+Uint32 GetLastInputTime(void)
+{
+    //Timestamp of the newest mouse event pumped so far
+    return lastInputTime;
+}
@@ -0,0 +1,31 @@
+/*
+SDL2 Batched Event Intake
+*/
+
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#include <SDL2/SDL.h>
+
+
+//Macros
+//===========================================================================
+#define EVENT_BATCH_SIZE 128 //most events handed out per frame
+
+
+//Types
+//===========================================================================
+typedef struct
+{
+    SDL_Event events[EVENT_BATCH_SIZE]; //pending events in queue order
+    int count;
+} EventBatch;
+
+
+//Functions
+//===========================================================================
+void InstallEventFilter(const Uint32 *types, int count);
+int PollEventBatch(EventBatch *batch);
+Uint32 GetLastInputTime(void);
+
+#endif
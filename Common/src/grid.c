@@ -0,0 +1,304 @@
+/*
+SDL2 Spatial Grid
+*/
+
+#include "grid.h"
+#include "jobs.h"
+
+
+//Types
+//===========================================================================
+typedef struct
+{
+    SpatialGrid *grid;
+    GridTestFunc test;
+    void *data;
+    GridPairList *list;
+} PairSearch;
+
+
+//Functions
+//===========================================================================
+int InitSpatialGrid(SpatialGrid *grid, int width, int height, int cellSize, 
+    int capacity)
+{
+    SDL_memset(grid, 0, sizeof(*grid));
+    grid->cellSize = SDL_max(cellSize, 1);
+    grid->cols = SDL_max((width + grid->cellSize - 1) / grid->cellSize, 1);
+    grid->rows = SDL_max((height + grid->cellSize - 1) / grid->cellSize, 1);
+    grid->capacity = capacity;
+    
+    //Allocate the cell table and the item lists
+    grid->cellStart = (int*)SDL_malloc((grid->cols * grid->rows + 1) * 
+        sizeof(int));
+    grid->cells = (int*)SDL_malloc(capacity * sizeof(int));
+    grid->ids = (int*)SDL_malloc(capacity * sizeof(int));
+    grid->items = (int*)SDL_malloc(capacity * sizeof(int));
+    
+    if(!grid->cellStart || !grid->cells || !grid->ids || !grid->items)
+    {
+        SDL_OutOfMemory();
+        FreeSpatialGrid(grid);
+        return 1;
+    }
+    
+    ClearSpatialGrid(grid);
+    SortSpatialGrid(grid);
+    return 0;
+}
+
+
+void FreeSpatialGrid(SpatialGrid *grid)
+{
+    SDL_free(grid->cellStart);
+    SDL_free(grid->cells);
+    SDL_free(grid->ids);
+    SDL_free(grid->items);
+    
+    for(int i = 0; i < GRID_PAIR_CHUNKS; i++)
+    {
+        FreeGridPairList(&grid->chunkPairs[i]);
+    }
+    
+    SDL_memset(grid, 0, sizeof(*grid));
+}
+
+
+void ClearSpatialGrid(SpatialGrid *grid)
+{
+    grid->count = 0;
+}
+
+
+static int GetCell(const SpatialGrid *grid, int x, int y)
+{
+    //Clamp to the edge cells
+    int col = SDL_min(SDL_max(x / grid->cellSize, 0), grid->cols - 1);
+    int row = SDL_min(SDL_max(y / grid->cellSize, 0), grid->rows - 1);
+    return row * grid->cols + col;
+}
+
+
+void SetSpatialGridCount(SpatialGrid *grid, int count)
+{
+    grid->count = SDL_min(count, grid->capacity);
+}
+
+
+void SetSpatialGridItem(SpatialGrid *grid, int i, int id, int x, int y)
+{
+    //Fill slots directly, so several threads can add items at once
+    if(i < grid->count)
+    {
+        grid->cells[i] = GetCell(grid, x, y);
+        grid->ids[i] = id;
+    }
+}
+
+
+void SortSpatialGrid(SpatialGrid *grid)
+{
+    //Counting sort: count the items in each cell, turn the counts into
+    //start offsets and then drop every item into place
+    int cellCount = grid->cols * grid->rows;
+    SDL_memset(grid->cellStart, 0, (cellCount + 1) * sizeof(int));
+    
+    for(int i = 0; i < grid->count; i++)
+    {
+        grid->cellStart[grid->cells[i] + 1]++;
+    }
+    
+    for(int i = 0; i < cellCount; i++)
+    {
+        grid->cellStart[i + 1] += grid->cellStart[i];
+    }
+    
+    //Fill each cell from its end so the start offsets come out right
+    for(int i = grid->count - 1; i >= 0; i--)
+    {
+        grid->items[--grid->cellStart[grid->cells[i] + 1]] = grid->ids[i];
+    }
+    
+    //Every end offset was moved back to where its cell starts, so shift
+    //them down by one cell
+    SDL_memmove(grid->cellStart, grid->cellStart + 1, 
+        cellCount * sizeof(int));
+    grid->cellStart[cellCount] = grid->count;
+}
+
+
+void QuerySpatialGrid(const SpatialGrid *grid, const SDL_Rect *area, 
+    GridItemFunc func, void *data)
+{
+    //Grow the area by half a cell, since items can reach that far past the
+    //cell their center is in
+    int half = grid->cellSize / 2;
+    int first = GetCell(grid, area->x - half, area->y - half);
+    int last = GetCell(grid, area->x + area->w + half, 
+        area->y + area->h + half);
+    
+    for(int row = first / grid->cols; row <= last / grid->cols; row++)
+    {
+        for(int col = first % grid->cols; col <= last % grid->cols; col++)
+        {
+            int cell = row * grid->cols + col;
+            
+            for(int i = grid->cellStart[cell]; i < grid->cellStart[cell + 1]; 
+                i++)
+            {
+                func(grid->items[i], data);
+            }
+        }
+    }
+}
+
+
+static void VisitCellPairs(const SpatialGrid *grid, int cell, 
+    GridPairFunc func, void *data)
+{
+    //Pair the cell with itself and the neighbors to the right and below, so
+    //every pair of nearby items is visited exactly once
+    static const int offsets[4][2] = {{1, 0}, {-1, 1}, {0, 1}, {1, 1}};
+    int col = cell % grid->cols;
+    int row = cell / grid->cols;
+    int start = grid->cellStart[cell];
+    int end = grid->cellStart[cell + 1];
+    
+    for(int i = start; i < end; i++)
+    {
+        //Items in the same cell
+        for(int j = i + 1; j < end; j++)
+        {
+            func(grid->items[i], grid->items[j], data);
+        }
+        
+        //Items in the neighboring cells
+        for(int n = 0; n < 4; n++)
+        {
+            int col2 = col + offsets[n][0];
+            int row2 = row + offsets[n][1];
+            
+            if(col2 < 0 || col2 >= grid->cols || row2 >= grid->rows)
+            {
+                continue;
+            }
+            
+            int cell2 = row2 * grid->cols + col2;
+            
+            for(int j = grid->cellStart[cell2]; 
+                j < grid->cellStart[cell2 + 1]; j++)
+            {
+                func(grid->items[i], grid->items[j], data);
+            }
+        }
+    }
+}
+
+
+static int ReservePairs(GridPairList *list, int count)
+{
+    if(count <= list->capacity)
+    {
+        return 0;
+    }
+    
+    //Grow by doubling so appending stays cheap
+    int capacity = SDL_max(SDL_max(list->capacity * 2, count), 64);
+    int *pairs = (int*)SDL_realloc(list->pairs, capacity * 2 * sizeof(int));
+    
+    if(!pairs)
+    {
+        return 1;
+    }
+    
+    list->pairs = pairs;
+    list->capacity = capacity;
+    return 0;
+}
+
+
+static void AddPairIfTested(int a, int b, void *data)
+{
+    PairSearch *search = (PairSearch*)data;
+    GridPairList *list = search->list;
+    
+    if(!search->test(a, b, search->data) || 
+        ReservePairs(list, list->count + 1))
+    {
+        return;
+    }
+    
+    list->pairs[list->count * 2] = a;
+    list->pairs[list->count * 2 + 1] = b;
+    list->count++;
+}
+
+
+static void SearchChunks(void *data, int start, int end)
+{
+    //Each chunk covers a fixed range of cells and has its own list
+    const PairSearch *args = (const PairSearch*)data;
+    SpatialGrid *grid = args->grid;
+    int cellCount = grid->cols * grid->rows;
+    int chunkSize = (cellCount + GRID_PAIR_CHUNKS - 1) / GRID_PAIR_CHUNKS;
+    
+    for(int chunk = start; chunk < end; chunk++)
+    {
+        PairSearch search = *args;
+        search.list = &grid->chunkPairs[chunk];
+        search.list->count = 0;
+        int last = SDL_min((chunk + 1) * chunkSize, cellCount);
+        
+        for(int cell = chunk * chunkSize; cell < last; cell++)
+        {
+            VisitCellPairs(grid, cell, &AddPairIfTested, &search);
+        }
+    }
+}
+
+
+void CollectGridPairs(SpatialGrid *grid, GridTestFunc test, void *data, 
+    GridPairList *list)
+{
+    //Search the cells in parallel. The test must be safe to call from
+    //several threads at once.
+    PairSearch search = {grid, test, data, NULL};
+    ParallelFor(&SearchChunks, &search, GRID_PAIR_CHUNKS, 1);
+    
+    //Join the chunks in cell order, so the result is the same no matter
+    //which thread searched what
+    int total = 0;
+    
+    for(int i = 0; i < GRID_PAIR_CHUNKS; i++)
+    {
+        total += grid->chunkPairs[i].count;
+    }
+    
+    list->count = 0;
+    
+    if(ReservePairs(list, total))
+    {
+        return;
+    }
+    
+    for(int i = 0; i < GRID_PAIR_CHUNKS; i++)
+    {
+        const GridPairList *chunk = &grid->chunkPairs[i];
+        
+        if(!chunk->count)
+        {
+            continue;
+        }
+        
+        SDL_memcpy(list->pairs + list->count * 2, chunk->pairs, 
+            chunk->count * 2 * sizeof(int));
+        list->count += chunk->count;
+    }
+}
+
+
+void FreeGridPairList(GridPairList *list)
+{
+    SDL_free(list->pairs);
+    SDL_memset(list, 0, sizeof(*list));
+}
@@ -0,0 +1,64 @@
+/*
+SDL2 Spatial Grid
+*/
+
+#ifndef GRID_H
+#define GRID_H
+
+#include <SDL2/SDL.h>
+
+
+//Macros
+//===========================================================================
+#define GRID_PAIR_CHUNKS 64 //cell ranges searched in parallel for pairs
+
+
+//Types
+//===========================================================================
+//Items are sorted into square cells by their center point. Items must be
+//no larger than a cell, so anything an item touches lies in the 3x3 block
+//of cells around it. Points outside the grid go into the nearest edge cell.
+typedef struct
+{
+    int *pairs;   //two ids per pair
+    int count;    //pairs in the list
+    int capacity;
+} GridPairList;
+
+
+typedef struct
+{
+    int cellSize;
+    int cols;
+    int rows;
+    int capacity;   //most items the grid can hold
+    int count;      //items added since the last clear
+    int *cellStart; //where each cell's items start in items (cells + 1)
+    int *cells;     //cell of each added item
+    int *ids;       //ids in the order they were added
+    int *items;     //ids sorted by cell
+    GridPairList chunkPairs[GRID_PAIR_CHUNKS];
+} SpatialGrid;
+
+
+typedef void (*GridItemFunc)(int id, void *data);
+typedef void (*GridPairFunc)(int a, int b, void *data);
+typedef int (*GridTestFunc)(int a, int b, void *data);
+
+
+//Functions
+//===========================================================================
+int InitSpatialGrid(SpatialGrid *grid, int width, int height, int cellSize, 
+    int capacity);
+void FreeSpatialGrid(SpatialGrid *grid);
+void ClearSpatialGrid(SpatialGrid *grid);
+void SetSpatialGridCount(SpatialGrid *grid, int count);
+void SetSpatialGridItem(SpatialGrid *grid, int i, int id, int x, int y);
+void SortSpatialGrid(SpatialGrid *grid);
+void QuerySpatialGrid(const SpatialGrid *grid, const SDL_Rect *area, 
+    GridItemFunc func, void *data);
+void CollectGridPairs(SpatialGrid *grid, GridTestFunc test, void *data, 
+    GridPairList *list);
+void FreeGridPairList(GridPairList *list);
+
+#endif
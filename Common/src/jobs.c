@@ -0,0 +1,283 @@
+/*
+SDL2 Job System
+*/
+
+#include "jobs.h"
+
+
+//Macros
+//===========================================================================
+#define MAX_JOB_WORKERS 63  //upper limit on worker threads
+#define JOB_QUEUE_SIZE  256 //jobs each queue can hold (power of 2)
+
+
+//Types
+//===========================================================================
+typedef struct
+{
+    JobFunc func;
+    void *data;
+    int start;
+    int end;
+    int grain;               //split until ranges are no bigger than this
+    SDL_atomic_t *remaining; //items of the loop that haven't run yet
+} Job;
+
+
+//The owner pushes and pops at the bottom, other threads steal from the top,
+//so the owner works depth first while thieves take the biggest ranges
+typedef struct
+{
+    SDL_SpinLock lock;
+    unsigned top;
+    unsigned bottom;
+    Job jobs[JOB_QUEUE_SIZE];
+} JobQueue;
+
+
+//Globals
+//===========================================================================
+//Queue 0 belongs to the thread calling ParallelFor, the others to workers
+static JobQueue queues[MAX_JOB_WORKERS + 1];
+static SDL_Thread *workers[MAX_JOB_WORKERS];
+static int workerCount = 0;
+static SDL_atomic_t workersRunning;
+static SDL_sem *wakeSem = NULL;
+
+
+//Functions
+//===========================================================================
+static int SDLCALL WorkerThread(void *data);
+
+
+void InitJobSystem(int count)
+{
+    SDL_memset(queues, 0, sizeof(queues));
+    workerCount = 0;
+    
+    //By default the caller and one worker per remaining core share the work
+    if(count <= 0)
+    {
+        count = SDL_GetCPUCount() - 1;
+    }
+    
+    count = SDL_min(count, MAX_JOB_WORKERS);
+    
+    if(count <= 0)
+    {
+        return;
+    }
+    
+    wakeSem = SDL_CreateSemaphore(0);
+    
+    if(!wakeSem)
+    {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+        return;
+    }
+    
+    SDL_AtomicSet(&workersRunning, 1);
+    
+    while(workerCount < count)
+    {
+        workers[workerCount] = SDL_CreateThread(&WorkerThread, "Worker", 
+            &queues[workerCount + 1]);
+            
+        if(!workers[workerCount])
+        {
+            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+            break;
+        }
+        
+        workerCount++;
+    }
+    
+    SDL_Log("Started %i job workers", workerCount);
+}
+
+
+void FreeJobSystem(void)
+{
+    //Wake every worker so it can see that it should exit
+    SDL_AtomicSet(&workersRunning, 0);
+    
+    for(int i = 0; i < workerCount; i++)
+    {
+        SDL_SemPost(wakeSem);
+    }
+    
+    for(int i = 0; i < workerCount; i++)
+    {
+        SDL_WaitThread(workers[i], NULL);
+    }
+    
+    workerCount = 0;
+    
+    if(wakeSem)
+    {
+        SDL_DestroySemaphore(wakeSem);
+        wakeSem = NULL;
+    }
+}
+
+
+int GetJobThreadCount(void)
+{
+    return workerCount + 1;
+}
+
+
+static int PushJob(JobQueue *queue, const Job *job)
+{
+    int pushed = 0;
+    SDL_AtomicLock(&queue->lock);
+    
+    if(queue->bottom - queue->top < JOB_QUEUE_SIZE)
+    {
+        queue->jobs[queue->bottom++ & (JOB_QUEUE_SIZE - 1)] = *job;
+        pushed = 1;
+    }
+    
+    SDL_AtomicUnlock(&queue->lock);
+    return pushed;
+}
+
+
+static int PopJob(JobQueue *queue, Job *job)
+{
+    int popped = 0;
+    SDL_AtomicLock(&queue->lock);
+    
+    if(queue->bottom != queue->top)
+    {
+        *job = queue->jobs[--queue->bottom & (JOB_QUEUE_SIZE - 1)];
+        popped = 1;
+    }
+    
+    SDL_AtomicUnlock(&queue->lock);
+    return popped;
+}
+
+
+static int StealJob(JobQueue *queue, Job *job)
+{
+    int stolen = 0;
+    SDL_AtomicLock(&queue->lock);
+    
+    if(queue->bottom != queue->top)
+    {
+        *job = queue->jobs[queue->top++ & (JOB_QUEUE_SIZE - 1)];
+        stolen = 1;
+    }
+    
+    SDL_AtomicUnlock(&queue->lock);
+    return stolen;
+}
+
+
+static void RunJob(Job job, int self)
+{
+    //Keep splitting off the upper half for others to steal. Splits fall on
+    //multiples of the grain, so every range starts where a chunk does.
+    while(job.end - job.start > job.grain)
+    {
+        int chunks = (job.end - job.start + job.grain - 1) / job.grain;
+        Job upper = job;
+        upper.start = job.start + chunks / 2 * job.grain;
+        
+        if(!PushJob(&queues[self], &upper))
+        {
+            break;
+        }
+        
+        job.end = upper.start;
+    }
+    
+    job.func(job.data, job.start, job.end);
+    SDL_AtomicAdd(job.remaining, job.start - job.end);
+}
+
+
+static int RunNextJob(int self)
+{
+    //Take our own newest job first, then steal the oldest from the others
+    Job job;
+    
+    if(PopJob(&queues[self], &job))
+    {
+        RunJob(job, self);
+        return 1;
+    }
+    
+    for(int i = 1; i <= workerCount; i++)
+    {
+        int victim = (self + i) % (workerCount + 1);
+        
+        if(StealJob(&queues[victim], &job))
+        {
+            RunJob(job, self);
+            return 1;
+        }
+    }
+    
+    return 0;
+}
+
+
+void ParallelFor(JobFunc func, void *data, int count, int grain)
+{
+    //Only one thread may run loops at a time, and jobs can't start loops
+    //of their own
+    if(count <= 0)
+    {
+        return;
+    }
+    
+    //Small loops, or no workers, run right here
+    grain = SDL_max(grain, 1);
+    
+    if(!workerCount || count <= grain)
+    {
+        func(data, 0, count);
+        return;
+    }
+    
+    //Queue the whole range and help out until every item has run
+    SDL_atomic_t remaining;
+    SDL_AtomicSet(&remaining, count);
+    Job job = {func, data, 0, count, grain, &remaining};
+    
+    if(!PushJob(&queues[0], &job))
+    {
+        func(data, 0, count);
+        return;
+    }
+    
+    for(int i = 0; i < workerCount; i++)
+    {
+        SDL_SemPost(wakeSem);
+    }
+    
+    while(SDL_AtomicGet(&remaining) > 0)
+    {
+        RunNextJob(0);
+    }
+}
+
+
+static int SDLCALL WorkerThread(void *data)
+{
+    int self = (int)((JobQueue*)data - queues);
+    
+    //Sleep until a loop starts, then work until there is nothing to steal
+    while(SDL_AtomicGet(&workersRunning))
+    {
+        SDL_SemWait(wakeSem);
+        
+        while(RunNextJob(self))
+        {
+        }
+    }
+    
+    return 0;
+}
@@ -0,0 +1,24 @@
+/*
+SDL2 Job System
+*/
+
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <SDL2/SDL.h>
+
+
+//Types
+//===========================================================================
+//Processes items [start, end) of a parallel loop. Called from any thread.
+typedef void (*JobFunc)(void *data, int start, int end);
+
+
+//Functions
+//===========================================================================
+void InitJobSystem(int workers);
+void FreeJobSystem(void);
+int GetJobThreadCount(void);
+void ParallelFor(JobFunc func, void *data, int count, int grain);
+
+#endif
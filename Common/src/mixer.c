@@ -0,0 +1,471 @@
+/*
+SDL2 Software Mixer
+*/
+
+#include "mixer.h"
+#include "telemetry.h"
+
+
+//Macros
+//===========================================================================
+#define MIXER_QUEUE_MASK (MIXER_QUEUE_SIZE - 1)
+
+
+//Types
+//===========================================================================
+typedef enum
+{
+    MIXER_PLAY,
+    MIXER_STOP,
+    MIXER_MUSIC
+} MixerCommandType;
+
+
+typedef struct
+{
+    MixerCommandType type;
+    int voice;
+    Uint32 serial;
+    const Sint16 *samples;
+    int frames;
+    float volume;
+    MixerReadFunc read;   //music source for MIXER_MUSIC
+    void *data;
+} MixerCommand;
+
+
+//Only the audio thread touches voices
+typedef struct
+{
+    const Sint16 *samples; //NULL while the voice is silent
+    int frames;
+    int pos;               //next frame to mix
+    float gain;
+    float target;          //gain at the end of the ramp
+    float step;            //gain change per frame
+    int ramp;              //frames left in the ramp
+    Uint32 serial;
+} MixerVoice;
+
+
+typedef int (*MixKernel)(float *out, const Sint16 *in, int count, 
+    float gain);
+typedef int (*ClampKernel)(float *out, int count);
+
+
+//Globals
+//===========================================================================
+static SDL_AudioDeviceID device = 0;
+static int channelCount = 0;
+static SDL_AudioCallback postMixFunc = NULL;
+static MixKernel mixKernel = NULL;
+static ClampKernel clampKernel = NULL;
+
+//The game thread is the only one to write commands and move the tail, the
+//audio thread the only one to read them and move the head, so neither ever
+//waits for the other
+static MixerCommand commands[MIXER_QUEUE_SIZE];
+static SDL_atomic_t queueHead;
+static SDL_atomic_t queueTail;
+
+static MixerVoice voices[MIXER_VOICES];
+static MixerVoice fading[MIXER_VOICES];     //sounds cut off by a new one
+static SDL_atomic_t finished[MIXER_VOICES]; //serial of the last sound done
+static Uint32 serials[MIXER_VOICES];        //serial of the last sound sent
+
+//Music is read by the audio thread in whatever amount it needs
+static MixerReadFunc musicFunc = NULL;
+static void *musicData = NULL;
+static Sint16 *musicSamples = NULL;
+static int musicCapacity = 0;
+
+
+//Functions
+//===========================================================================
+//Each kernel adds 16-bit samples times a constant gain to a float buffer
+static void MixSamples(float *out, const Sint16 *in, int count, float gain)
+{
+    for(int i = 0; i < count; i++)
+    {
+        out[i] += in[i] * gain;
+    }
+}
+
+
+static void ClampSamples(float *out, int count)
+{
+    for(int i = 0; i < count; i++)
+    {
+        out[i] = SDL_max(SDL_min(out[i], 1.0f), -1.0f);
+    }
+}
+
+
+#ifdef __SSE2__
+static int MixSamplesSSE2(float *out, const Sint16 *in, int count, 
+    float gain)
+{
+    const __m128 scale = _mm_set1_ps(gain);
+    int i = 0;
+    
+    for(; i + 8 <= count; i += 8)
+    {
+        //Sign extend the samples by putting them in the top half of each
+        //32-bit lane and shifting them back down
+        __m128i s = _mm_loadu_si128((const __m128i*)(in + i));
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), 
+            _mm_mul_ps(_mm_cvtepi32_ps(lo), scale)));
+        _mm_storeu_ps(out + i + 4, _mm_add_ps(_mm_loadu_ps(out + i + 4), 
+            _mm_mul_ps(_mm_cvtepi32_ps(hi), scale)));
+    }
+    
+    return i;
+}
+
+
+static int ClampSamplesSSE2(float *out, int count)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 minusOne = _mm_set1_ps(-1.0f);
+    int i = 0;
+    
+    for(; i + 4 <= count; i += 4)
+    {
+        __m128 s = _mm_loadu_ps(out + i);
+        _mm_storeu_ps(out + i, _mm_max_ps(_mm_min_ps(s, one), minusOne));
+    }
+    
+    return i;
+}
+#endif
+
+
+#ifdef __ARM_NEON
+static int MixSamplesNEON(float *out, const Sint16 *in, int count, 
+    float gain)
+{
+    int i = 0;
+    
+    for(; i + 8 <= count; i += 8)
+    {
+        int16x8_t s = vld1q_s16(in + i);
+        float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(s)));
+        float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(s)));
+        vst1q_f32(out + i, vmlaq_n_f32(vld1q_f32(out + i), lo, gain));
+        vst1q_f32(out + i + 4, vmlaq_n_f32(vld1q_f32(out + i + 4), hi, gain));
+    }
+    
+    return i;
+}
+
+
+static int ClampSamplesNEON(float *out, int count)
+{
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    const float32x4_t minusOne = vdupq_n_f32(-1.0f);
+    int i = 0;
+    
+    for(; i + 4 <= count; i += 4)
+    {
+        float32x4_t s = vld1q_f32(out + i);
+        vst1q_f32(out + i, vmaxq_f32(vminq_f32(s, one), minusOne));
+    }
+    
+    return i;
+}
+#endif
+
+
+static void RampVoice(MixerVoice *voice, float target)
+{
+    voice->target = target;
+    voice->step = (target - voice->gain) / MIXER_RAMP;
+    voice->ramp = MIXER_RAMP;
+}
+
+
+static void RunCommands(void)
+{
+    //Apply everything the game thread sent since the last buffer
+    int head = SDL_AtomicGet(&queueHead);
+    int tail = SDL_AtomicGet(&queueTail);
+    
+    for(; head != tail; head = (head + 1) & MIXER_QUEUE_MASK)
+    {
+        const MixerCommand *command = &commands[head];
+        MixerVoice *voice = &voices[command->voice];
+        
+        if(command->type == MIXER_MUSIC)
+        {
+            musicFunc = command->read;
+            musicData = command->data;
+        }
+        else if(command->type == MIXER_PLAY)
+        {
+            //Let whatever the voice was playing fade out on the side
+            if(voice->samples)
+            {
+                fading[command->voice] = *voice;
+                RampVoice(&fading[command->voice], 0);
+            }
+            
+            //Fade in so the sound doesn't start with a click
+            voice->samples = command->samples;
+            voice->frames = command->frames;
+            voice->pos = 0;
+            voice->gain = 0;
+            voice->serial = command->serial;
+            RampVoice(voice, command->volume);
+        }
+        else if(voice->samples)
+        {
+            //Fade out, the voice goes quiet once the ramp is done
+            voice->serial = command->serial;
+            RampVoice(voice, 0);
+        }
+        else
+        {
+            SDL_AtomicSet(&finished[command->voice], (int)command->serial);
+        }
+    }
+    
+    SDL_AtomicSet(&queueHead, head);
+}
+
+
+static int MixVoice(MixerVoice *voice, float *out, int frames)
+{
+    const Sint16 *in = voice->samples + voice->pos * channelCount;
+    int count = SDL_min(frames, voice->frames - voice->pos);
+    int done = 0;
+    
+    //Ramps change the gain every frame, so do them one frame at a time
+    for(; done < count && voice->ramp; done++, voice->ramp--)
+    {
+        voice->gain += voice->step;
+        
+        for(int c = 0; c < channelCount; c++)
+        {
+            int i = done * channelCount + c;
+            out[i] += in[i] * voice->gain * (1.0f / 32768);
+        }
+    }
+    
+    if(!voice->ramp)
+    {
+        voice->gain = voice->target;
+    }
+    
+    //Mix the rest at a constant gain, using the widest kernel we have
+    int start = done * channelCount;
+    int samples = count * channelCount - start;
+    float gain = voice->gain * (1.0f / 32768);
+    int mixed = mixKernel && gain != 0 ? 
+        mixKernel(out + start, in + start, samples, gain) : 0;
+    
+    if(gain != 0)
+    {
+        MixSamples(out + start + mixed, in + start + mixed, samples - mixed, 
+            gain);
+    }
+    
+    voice->pos += count;
+    
+    //Is the sound over or faded out?
+    if(voice->pos == voice->frames || (!voice->ramp && voice->gain == 0))
+    {
+        voice->samples = NULL;
+        return 1;
+    }
+    
+    return 0;
+}
+
+
+static void SDLCALL MixAudio(void *data, Uint8 *stream, int len)
+{
+    //Nothing in here may block, so the game thread only talks to us
+    //through the command queue
+    Uint64 start = SDL_GetPerformanceCounter();
+    float *out = (float*)stream;
+    int count = len / (int)sizeof(float);
+    int frames = count / channelCount;
+    SDL_memset(stream, 0, len);
+    RunCommands();
+    
+    for(int i = 0; i < MIXER_VOICES; i++)
+    {
+        //Let the game thread know once a voice is free again
+        if(voices[i].samples && MixVoice(&voices[i], out, frames))
+        {
+            SDL_AtomicSet(&finished[i], (int)voices[i].serial);
+        }
+        
+        if(fading[i].samples)
+        {
+            MixVoice(&fading[i], out, frames);
+        }
+    }
+    
+    //Whatever part of the music isn't ready yet is left silent
+    if(musicFunc)
+    {
+        int got = musicFunc(musicData, (Uint8*)musicSamples, 
+            SDL_min(count, musicCapacity) * (int)sizeof(Sint16)) / 
+            (int)sizeof(Sint16);
+        int mixed = mixKernel ? 
+            mixKernel(out, musicSamples, got, 1.0f / 32768) : 0;
+        MixSamples(out + mixed, musicSamples + mixed, got - mixed, 
+            1.0f / 32768);
+    }
+    
+    int done = clampKernel ? clampKernel(out, count) : 0;
+    ClampSamples(out + done, count - done);
+    RecordTelemetrySince(TELEMETRY_AUDIO_MIX, start);
+    
+    if(postMixFunc)
+    {
+        postMixFunc(data, stream, len);
+    }
+}
+
+
+int OpenSoftMixer(int rate, int channels, int samples, 
+    SDL_AudioCallback postMix)
+{
+    //Mix in float and let SDL convert to whatever the device wants
+    SDL_AudioSpec want;
+    SDL_AudioSpec have;
+    SDL_memset(&want, 0, sizeof(want));
+    want.freq = rate;
+    want.format = AUDIO_F32SYS;
+    want.channels = (Uint8)channels;
+    want.samples = (Uint16)samples;
+    want.callback = &MixAudio;
+    
+    SDL_memset(voices, 0, sizeof(voices));
+    SDL_memset(fading, 0, sizeof(fading));
+    SDL_memset(finished, 0, sizeof(finished));
+    SDL_memset(serials, 0, sizeof(serials));
+    SDL_AtomicSet(&queueHead, 0);
+    SDL_AtomicSet(&queueTail, 0);
+    channelCount = channels;
+    postMixFunc = postMix;
+    musicFunc = NULL;
+    musicData = NULL;
+    
+    //Pick the widest kernels the CPU supports
+    mixKernel = NULL;
+    clampKernel = NULL;
+    
+    #ifdef __SSE2__
+    if(SDL_HasSSE2())
+    {
+        mixKernel = &MixSamplesSSE2;
+        clampKernel = &ClampSamplesSSE2;
+    }
+    #endif
+    
+    #ifdef __ARM_NEON
+    if(SDL_HasNEON())
+    {
+        mixKernel = &MixSamplesNEON;
+        clampKernel = &ClampSamplesNEON;
+    }
+    #endif
+    
+    device = SDL_OpenAudioDevice(NULL, 0, &want, &have, 0);
+    
+    if(!device)
+    {
+        return 1;
+    }
+    
+    //Room for the music of one whole buffer
+    musicCapacity = have.samples * have.channels;
+    musicSamples = (Sint16*)SDL_malloc(musicCapacity * sizeof(Sint16));
+    
+    if(!musicSamples)
+    {
+        CloseSoftMixer();
+        SDL_OutOfMemory();
+        return 1;
+    }
+    
+    SDL_PauseAudioDevice(device, 0);
+    return 0;
+}
+
+
+void CloseSoftMixer(void)
+{
+    if(device)
+    {
+        SDL_CloseAudioDevice(device);
+        device = 0;
+    }
+    
+    SDL_free(musicSamples);
+    musicSamples = NULL;
+    musicCapacity = 0;
+}
+
+
+static int SendCommand(MixerCommandType type, int voice, 
+    const Sint16 *samples, int frames, float volume, MixerReadFunc read, 
+    void *data)
+{
+    //Drop the command if the audio thread has fallen this far behind
+    int tail = SDL_AtomicGet(&queueTail);
+    int next = (tail + 1) & MIXER_QUEUE_MASK;
+    
+    if(voice < 0 || voice >= MIXER_VOICES || 
+        next == SDL_AtomicGet(&queueHead))
+    {
+        return -1;
+    }
+    
+    //Music isn't played on a voice, so it doesn't get a serial
+    MixerCommand *command = &commands[tail];
+    command->type = type;
+    command->voice = voice;
+    command->serial = type == MIXER_MUSIC ? 0 : ++serials[voice];
+    command->samples = samples;
+    command->frames = frames;
+    command->volume = volume;
+    command->read = read;
+    command->data = data;
+    
+    //Setting the tail publishes the command, SDL_AtomicSet is a full
+    //barrier so the audio thread can't see the tail before the command
+    SDL_AtomicSet(&queueTail, next);
+    return voice;
+}
+
+
+int PlaySoftVoice(int voice, const Sint16 *samples, int frames, float volume)
+{
+    return SendCommand(MIXER_PLAY, voice, samples, frames, volume, NULL, 
+        NULL);
+}
+
+
+int StopSoftVoice(int voice)
+{
+    return SendCommand(MIXER_STOP, voice, NULL, 0, 0, NULL, NULL);
+}
+
+
+int IsSoftVoicePlaying(int voice)
+{
+    //A voice plays until it reports the last sound sent to it as done
+    return (Uint32)SDL_AtomicGet(&finished[voice]) != serials[voice];
+}
+
+
+int SetSoftMusic(MixerReadFunc read, void *data)
+{
+    return SendCommand(MIXER_MUSIC, 0, NULL, 0, 0, read, data) < 0;
+}
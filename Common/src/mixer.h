@@ -0,0 +1,34 @@
+/*
+SDL2 Software Mixer
+*/
+
+#ifndef MIXER_H
+#define MIXER_H
+
+#include <SDL2/SDL.h>
+
+
+//Macros
+//===========================================================================
+#define MIXER_VOICES     64
+#define MIXER_QUEUE_SIZE 256 //commands in flight (power of 2)
+#define MIXER_RAMP       64  //frames it takes to fade a voice in or out
+
+
+//Types
+//===========================================================================
+//Fills dest with up to len bytes of music and returns how many it wrote
+typedef int (*MixerReadFunc)(void *data, Uint8 *dest, int len);
+
+
+//Functions
+//===========================================================================
+int OpenSoftMixer(int rate, int channels, int samples, 
+    SDL_AudioCallback postMix);
+void CloseSoftMixer(void);
+int PlaySoftVoice(int voice, const Sint16 *samples, int frames, float volume);
+int StopSoftVoice(int voice);
+int IsSoftVoicePlaying(int voice);
+int SetSoftMusic(MixerReadFunc read, void *data);
+
+#endif
@@ -0,0 +1,222 @@
+/*
+SDL2 Command Line Options
+*/
+
+#include <time.h>
+
+#include "options.h"
+
+
+//Macros
+//===========================================================================
+#define DEFAULT_FPS            60
+#define DEFAULT_MAX_BUBBLES    10
+#define DEFAULT_TELEMETRY_FILE "telemetry.csv" //written by benchmarks
+
+
+//Types
+//===========================================================================
+typedef struct
+{
+    const char *name;
+    int feature;        //what a demo has to support to use the option
+} OptionFeature;
+
+
+//Globals
+//===========================================================================
+static const OptionFeature optionFeatures[] = {
+    {"--bubbles",          OPTIONS_SIMULATION},
+    {"--max-bubbles",      OPTIONS_SIMULATION},
+    {"--seed",             OPTIONS_SIMULATION},
+    {"--jobs",             OPTIONS_SIMULATION},
+    {"--late-latch",       OPTIONS_SIMULATION},
+    {"--record",           OPTIONS_SIMULATION},
+    {"--replay",           OPTIONS_SIMULATION},
+    {"--fast-replay",      OPTIONS_SIMULATION},
+    {"--audio-rate",       OPTIONS_AUDIO},
+    {"--audio-channels",   OPTIONS_AUDIO},
+    {"--audio-buffer",     OPTIONS_AUDIO},
+    {"--voices",           OPTIONS_AUDIO},
+    {"--soft-mixer",       OPTIONS_AUDIO},
+    {"--music",            OPTIONS_AUDIO},
+    {"--stream-threshold", OPTIONS_AUDIO},
+    {"--dirty-rects",      OPTIONS_DIRTY_RECTS}
+};
+
+
+//Functions
+//===========================================================================
+static void CheckOptionUsed(const char *arg, int features)
+{
+    //Options the demo has no use for are still parsed, but shouldn't be
+    //silently ignored
+    int count = sizeof(optionFeatures) / sizeof(optionFeatures[0]);
+    
+    for(int i = 0; i < count; i++)
+    {
+        if(SDL_strcmp(arg, optionFeatures[i].name) == 0 && 
+            !(features & optionFeatures[i].feature))
+        {
+            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, 
+                "%s is not used by this demo.", arg);
+            return;
+        }
+    }
+}
+
+
+static const char *NextArg(int *i, int argc, char **argv)
+{
+    //Fetch the value that follows an option
+    if(*i + 1 >= argc)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Missing value for %s", 
+            argv[*i]);
+        return NULL;
+    }
+    
+    return argv[++*i];
+}
+
+
+int ParseOptions(Options *options, int argc, char **argv, int features)
+{
+    //Set defaults
+    int haveFps = 0;
+    SDL_memset(options, 0, sizeof(*options));
+    options->seed = (Uint32)time(0);
+    options->fps = DEFAULT_FPS;
+    options->maxBubbles = DEFAULT_MAX_BUBBLES;
+    
+    //Parse options
+    for(int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        const char *value = NULL;
+        CheckOptionUsed(arg, features);
+        
+        if(SDL_strcmp(arg, "--bench") == 0)
+        {
+            options->bench = 1;
+            continue;
+        }
+        
+        if(SDL_strcmp(arg, "--late-latch") == 0)
+        {
+            options->lateLatch = 1;
+            continue;
+        }
+        
+        if(SDL_strcmp(arg, "--dirty-rects") == 0)
+        {
+            options->dirtyRects = 1;
+            continue;
+        }
+        
+        if(SDL_strcmp(arg, "--soft-mixer") == 0)
+        {
+            options->softMixer = 1;
+            continue;
+        }
+        
+        if(SDL_strcmp(arg, "--fast-replay") == 0)
+        {
+            options->fastReplay = 1;
+            continue;
+        }
+        
+        //All other options take a value
+        if(!(value = NextArg(&i, argc, argv)))
+        {
+            return 1;
+        }
+        
+        if(SDL_strcmp(arg, "--frames") == 0)
+        {
+            options->frames = SDL_atoi(value);
+        }
+        else if(SDL_strcmp(arg, "--bubbles") == 0)
+        {
+            options->bubbles = SDL_atoi(value);
+        }
+        else if(SDL_strcmp(arg, "--max-bubbles") == 0)
+        {
+            options->maxBubbles = SDL_atoi(value);
+        }
+        else if(SDL_strcmp(arg, "--jobs") == 0)
+        {
+            options->jobs = SDL_atoi(value);
+        }
+        else if(SDL_strcmp(arg, "--audio-rate") == 0)
+        {
+            options->audioRate = SDL_atoi(value);
+        }
+        else if(SDL_strcmp(arg, "--audio-channels") == 0)
+        {
+            options->audioChannels = SDL_atoi(value);
+        }
+        else if(SDL_strcmp(arg, "--audio-buffer") == 0)
+        {
+            options->audioBuffer = SDL_strcmp(value, "probe") == 0 ? -1 : 
+                SDL_atoi(value);
+        }
+        else if(SDL_strcmp(arg, "--voices") == 0)
+        {
+            options->voices = SDL_atoi(value);
+        }
+        else if(SDL_strcmp(arg, "--music") == 0)
+        {
+            options->musicFile = value;
+        }
+        else if(SDL_strcmp(arg, "--stream-threshold") == 0)
+        {
+            options->streamThreshold = SDL_atoi(value);
+        }
+        else if(SDL_strcmp(arg, "--seed") == 0)
+        {
+            options->seed = (Uint32)SDL_strtoul(value, NULL, 0);
+        }
+        else if(SDL_strcmp(arg, "--fps") == 0)
+        {
+            options->fps = SDL_atof(value);
+            haveFps = 1;
+        }
+        else if(SDL_strcmp(arg, "--telemetry") == 0)
+        {
+            options->telemetryFile = value;
+        }
+        else if(SDL_strcmp(arg, "--record") == 0)
+        {
+            options->recordFile = value;
+        }
+        else if(SDL_strcmp(arg, "--replay") == 0)
+        {
+            options->replayFile = value;
+        }
+        else
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unknown option %s", 
+                arg);
+            return 1;
+        }
+    }
+    
+    //Always leave room for the initial bubbles
+    options->maxBubbles = SDL_max(options->maxBubbles, options->bubbles);
+    
+    //Benchmarks and fast replays run uncapped unless a rate was given
+    //explicitly
+    if((options->bench || options->fastReplay) && !haveFps)
+    {
+        options->fps = 0;
+    }
+    
+    //Only benchmarks write telemetry without being asked to
+    if(options->bench && !options->telemetryFile)
+    {
+        options->telemetryFile = DEFAULT_TELEMETRY_FILE;
+    }
+    
+    return 0;
+}
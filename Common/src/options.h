@@ -0,0 +1,49 @@
+/*
+SDL2 Command Line Options
+*/
+
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <SDL2/SDL.h>
+
+
+//Macros
+//===========================================================================
+#define OPTIONS_SIMULATION  0x1 //bubbles, input recording and replay
+#define OPTIONS_AUDIO       0x2 //audio output and music
+#define OPTIONS_DIRTY_RECTS 0x4 //partial redraws
+
+
+//Types
+//===========================================================================
+typedef struct
+{
+    int bench;                 //run headless and uncapped
+    int frames;                //frames to run before quitting (0 = forever)
+    int bubbles;               //bubbles to spawn at startup
+    int maxBubbles;            //most bubbles alive at once
+    int jobs;                  //job worker threads (0 = one per extra core)
+    Uint32 seed;               //random seed
+    double fps;                //target frame rate (0 = uncapped)
+    int lateLatch;             //sample the mouse again just before drawing
+    int dirtyRects;            //only redraw damaged parts of the window
+    int audioRate;             //output sample rate (0 = mixer default)
+    int audioChannels;         //output channels (0 = mixer default)
+    int audioBuffer;           //samples per audio buffer (-1 = probe)
+    int voices;                //sounds that can play at once (0 = default)
+    int softMixer;             //mix sounds ourselves instead of SDL_mixer
+    const char *musicFile;     //music to loop in the background
+    int streamThreshold;       //bytes above which music is streamed
+    const char *telemetryFile; //where to write telemetry (NULL = don't)
+    const char *recordFile;    //where to record input (NULL = don't)
+    const char *replayFile;    //recorded input to play back instead
+    int fastReplay;            //replay as fast as the simulation can run
+} Options;
+
+
+//Functions
+//===========================================================================
+int ParseOptions(Options *options, int argc, char **argv, int features);
+
+#endif
@@ -0,0 +1,89 @@
+/*
+SDL2 Frame Pacer
+*/
+
+#include "pacer.h"
+
+
+//Macros
+//===========================================================================
+//SDL_Delay can oversleep by a millisecond or two depending on the OS
+//scheduler, so the last stretch before each deadline is spent spinning.
+#define SPIN_TIME_MS 2
+
+
+//Functions
+//===========================================================================
+void InitFramePacer(FramePacer *pacer, double fps)
+{
+    pacer->freq = SDL_GetPerformanceFrequency();
+    pacer->spinTicks = pacer->freq * SPIN_TIME_MS / 1000;
+    pacer->lastTime = SDL_GetPerformanceCounter();
+    pacer->jitterTicks = 0;
+    SetFramePacerRate(pacer, fps);
+}
+
+
+void SetFramePacerRate(FramePacer *pacer, double fps)
+{
+    //A rate of 0 disables the limiter
+    if(fps > 0)
+    {
+        pacer->period = (Uint64)(pacer->freq / fps + 0.5);
+    }
+    else
+    {
+        pacer->period = 0;
+    }
+    
+    //Restart the schedule from the previous frame
+    pacer->deadline = pacer->lastTime + pacer->period;
+}
+
+
+void WaitForNextFrame(FramePacer *pacer)
+{
+    Uint64 now = SDL_GetPerformanceCounter();
+    
+    if(pacer->period)
+    {
+        //Sleep until we are close to the deadline, then spin for the rest
+        if(now < pacer->deadline)
+        {
+            Uint64 remaining = pacer->deadline - now;
+            
+            if(remaining > pacer->spinTicks)
+            {
+                SDL_Delay((Uint32)((remaining - pacer->spinTicks) * 1000 / 
+                    pacer->freq));
+            }
+            
+            while((now = SDL_GetPerformanceCounter()) < pacer->deadline);
+        }
+        
+        //Schedule the next frame relative to this deadline rather than to
+        //the time we woke up so errors do not accumulate.
+        pacer->jitterTicks = (Sint64)(now - pacer->deadline);
+        pacer->deadline += pacer->period;
+        
+        //If we fell more than a whole frame behind, resync instead of
+        //rushing through several frames to catch up.
+        if(now > pacer->deadline)
+        {
+            pacer->deadline = now + pacer->period;
+        }
+    }
+    else
+    {
+        pacer->jitterTicks = 0;
+    }
+    
+    //Remember when this frame started, in case the rate changes
+    pacer->lastTime = now;
+}
+
+
+double GetFrameJitter(const FramePacer *pacer)
+{
+    return pacer->jitterTicks * 1000.0 / pacer->freq;
+}
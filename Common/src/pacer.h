@@ -0,0 +1,31 @@
+/*
+SDL2 Frame Pacer
+*/
+
+#ifndef PACER_H
+#define PACER_H
+
+#include <SDL2/SDL.h>
+
+
+//Types
+//===========================================================================
+typedef struct
+{
+    Uint64 freq;        //performance counter ticks per second
+    Uint64 period;      //ticks per frame (0 means uncapped)
+    Uint64 spinTicks;   //how close to the deadline we stop sleeping and spin
+    Uint64 deadline;    //when the next frame is due to start
+    Uint64 lastTime;    //when the previous frame started
+    Sint64 jitterTicks; //how late the last frame started
+} FramePacer;
+
+
+//Functions
+//===========================================================================
+void InitFramePacer(FramePacer *pacer, double fps);
+void SetFramePacerRate(FramePacer *pacer, double fps);
+void WaitForNextFrame(FramePacer *pacer);
+double GetFrameJitter(const FramePacer *pacer);
+
+#endif
@@ -0,0 +1,242 @@
+/*
+SDL2 Asset Pack
+*/
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+    #define USE_MMAP
+#elif (defined(__unix__) || defined(__APPLE__)) && !defined(__ANDROID__)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #define USE_MMAP
+#endif
+
+#ifdef USE_LZ4
+#include <lz4.h>
+#endif
+
+#include "pack.h"
+
+
+//Functions
+//===========================================================================
+#ifdef USE_MMAP
+static int MapPack(AssetPack *pack, const char *filename)
+{
+    #ifdef _WIN32
+    //Map the whole file read-only
+    HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, 
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    LARGE_INTEGER size;
+    
+    if(file == INVALID_HANDLE_VALUE)
+    {
+        return 1;
+    }
+    
+    if(!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return 1;
+    }
+    
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, 
+        NULL);
+        
+    if(!mapping)
+    {
+        CloseHandle(file);
+        return 1;
+    }
+    
+    pack->base = (const Uint8*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    
+    if(!pack->base)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return 1;
+    }
+    
+    pack->size = (size_t)size.QuadPart;
+    pack->file = file;
+    pack->mapping = mapping;
+    return 0;
+    #else
+    //Map the whole file read-only
+    int fd = open(filename, O_RDONLY);
+    struct stat info;
+    
+    if(fd == -1)
+    {
+        return 1;
+    }
+    
+    if(fstat(fd, &info) == -1 || info.st_size == 0)
+    {
+        close(fd);
+        return 1;
+    }
+    
+    void *base = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 
+        0);
+    close(fd);
+    
+    if(base == MAP_FAILED)
+    {
+        return 1;
+    }
+    
+    pack->base = (const Uint8*)base;
+    pack->size = (size_t)info.st_size;
+    pack->mapping = base;
+    return 0;
+    #endif
+}
+#endif
+
+
+static int ReadPack(AssetPack *pack, const char *filename)
+{
+    //Fall back to reading the whole file into memory
+    SDL_RWops *file = SDL_RWFromFile(filename, "rb");
+    
+    if(!file)
+    {
+        return 1;
+    }
+    
+    Sint64 size = SDL_RWsize(file);
+    Uint8 *base = size > 0 ? (Uint8*)SDL_malloc((size_t)size) : NULL;
+    
+    if(!base || SDL_RWread(file, base, (size_t)size, 1) != 1)
+    {
+        SDL_free(base);
+        SDL_RWclose(file);
+        return 1;
+    }
+    
+    SDL_RWclose(file);
+    pack->base = base;
+    pack->size = (size_t)size;
+    return 0;
+}
+
+
+int OpenPack(AssetPack *pack, const char *filename)
+{
+    SDL_memset(pack, 0, sizeof(*pack));
+    
+    #ifdef USE_MMAP
+    if(MapPack(pack, filename) && ReadPack(pack, filename))
+    #else
+    if(ReadPack(pack, filename))
+    #endif
+    {
+        return 1;
+    }
+    
+    //Validate the header and index
+    const PackHeader *header = (const PackHeader*)pack->base;
+    
+    if(pack->size < sizeof(PackHeader) || header->magic != PACK_MAGIC || 
+        header->version != PACK_VERSION || 
+        header->count > (pack->size - sizeof(PackHeader)) / sizeof(PackEntry))
+    {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "%s is not a valid pack", 
+            filename);
+        ClosePack(pack);
+        return 1;
+    }
+    
+    pack->header = header;
+    pack->entries = (const PackEntry*)(pack->base + sizeof(PackHeader));
+    return 0;
+}
+
+
+void ClosePack(AssetPack *pack)
+{
+    if(!pack->base)
+    {
+        return;
+    }
+    
+    //Unmap or free the pack contents
+    if(!pack->mapping)
+    {
+        SDL_free((void*)pack->base);
+    }
+    #if defined(_WIN32)
+    else
+    {
+        UnmapViewOfFile(pack->base);
+        CloseHandle((HANDLE)pack->mapping);
+        CloseHandle((HANDLE)pack->file);
+    }
+    #elif defined(USE_MMAP)
+    else
+    {
+        munmap(pack->mapping, pack->size);
+    }
+    #endif
+    
+    SDL_memset(pack, 0, sizeof(*pack));
+}
+
+
+const PackEntry *FindPackEntry(const AssetPack *pack, const char *name, 
+    PackType type)
+{
+    if(!pack->header)
+    {
+        return NULL;
+    }
+    
+    //Find a valid entry with the given name and type
+    for(Uint32 i = 0; i < pack->header->count; i++)
+    {
+        const PackEntry *entry = &pack->entries[i];
+        
+        if(entry->type == (Uint32)type && 
+            SDL_strncmp(entry->name, name, PACK_NAME_SIZE) == 0)
+        {
+            return entry->offset <= pack->size && 
+                entry->size <= pack->size - entry->offset ? entry : NULL;
+        }
+    }
+    
+    return NULL;
+}
+
+
+const void *GetPackData(const AssetPack *pack, const PackEntry *entry)
+{
+    //Uncompressed entries can be used straight from the pack
+    return entry->flags & PACK_LZ4 ? NULL : pack->base + entry->offset;
+}
+
+
+int ReadPackEntry(const AssetPack *pack, const PackEntry *entry, void *dest)
+{
+    //Copy or decompress an entry into the given buffer
+    if(!(entry->flags & PACK_LZ4))
+    {
+        SDL_memcpy(dest, pack->base + entry->offset, entry->size);
+        return 0;
+    }
+    
+    #ifdef USE_LZ4
+    if(LZ4_decompress_safe((const char*)pack->base + entry->offset, 
+        (char*)dest, (int)entry->size, (int)entry->rawSize) == 
+        (int)entry->rawSize)
+    {
+        return 0;
+    }
+    #endif
+    
+    return SDL_SetError("Failed to decompress %s", entry->name);
+}
@@ -0,0 +1,83 @@
+/*
+SDL2 Asset Pack
+*/
+
+#ifndef PACK_H
+#define PACK_H
+
+#include <SDL2/SDL.h>
+
+
+//Macros
+//===========================================================================
+#define PACK_MAGIC        0x4B504453 //"SDPK"
+#define PACK_VERSION      1
+#define PACK_NAME_SIZE    64
+#define PACK_ALIGN        16         //alignment of every data block
+#define PACK_PIXEL_FORMAT SDL_PIXELFORMAT_ARGB8888
+
+//Entry flags
+#define PACK_LZ4          1
+
+
+//Types
+//===========================================================================
+typedef enum
+{
+    PACK_IMAGE,
+    PACK_SOUND,
+    PACK_FONT
+} PackType;
+
+
+//Everything in a pack is stored in the byte order of the machine that
+//wrote it, so a pack with a foreign byte order fails the magic check.
+typedef struct
+{
+    Uint32 magic;
+    Uint32 version;
+    Uint32 count;
+    Sint32 audioFreq;     //mixer format the sounds were converted to
+    Uint16 audioFormat;
+    Uint16 audioChannels;
+    Uint32 reserved;
+} PackHeader;
+
+
+typedef struct
+{
+    char name[PACK_NAME_SIZE]; //path the asset is requested by
+    Uint32 type;
+    Uint32 flags;
+    Uint32 offset;             //from the start of the pack
+    Uint32 size;               //stored size
+    Uint32 rawSize;            //size after decompression
+    Uint32 format;             //pixel format for images
+    Sint32 width;
+    Sint32 height;
+    Sint32 pitch;
+    Uint32 reserved;
+} PackEntry;
+
+
+typedef struct
+{
+    const Uint8 *base;
+    size_t size;
+    const PackHeader *header;
+    const PackEntry *entries;
+    void *file;                //platform handles, mapping is NULL when the
+    void *mapping;             //pack was read into memory instead
+} AssetPack;
+
+
+//Functions
+//===========================================================================
+int OpenPack(AssetPack *pack, const char *filename);
+void ClosePack(AssetPack *pack);
+const PackEntry *FindPackEntry(const AssetPack *pack, const char *name, 
+    PackType type);
+const void *GetPackData(const AssetPack *pack, const PackEntry *entry);
+int ReadPackEntry(const AssetPack *pack, const PackEntry *entry, void *dest);
+
+#endif
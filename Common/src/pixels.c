@@ -0,0 +1,332 @@
+/*
+SDL2 Pixel Formats
+*/
+
+#include "pixels.h"
+
+
+//Globals
+//===========================================================================
+static Uint32 nativeFormat = SDL_PIXELFORMAT_ARGB8888;
+static SDL_BlendMode imageBlendMode = SDL_BLENDMODE_BLEND;
+static int premultiply = 0;
+
+
+//Functions
+//===========================================================================
+static Uint32 AddAlpha(Uint32 format)
+{
+    //Swap the padding byte of a 32-bit format for an alpha channel
+    switch(format)
+    {
+    case SDL_PIXELFORMAT_RGB888:
+        return SDL_PIXELFORMAT_ARGB8888;
+        
+    case SDL_PIXELFORMAT_BGR888:
+        return SDL_PIXELFORMAT_ABGR8888;
+        
+    case SDL_PIXELFORMAT_RGBX8888:
+        return SDL_PIXELFORMAT_RGBA8888;
+        
+    case SDL_PIXELFORMAT_BGRX8888:
+        return SDL_PIXELFORMAT_BGRA8888;
+        
+    default:
+        return format;
+    }
+}
+
+
+static int IsImageFormat(Uint32 format)
+{
+    //We only produce 32-bit formats with 8 bits of alpha
+    return !SDL_ISPIXELFORMAT_FOURCC(format) && 
+        SDL_BITSPERPIXEL(format) == 32 && SDL_ISPIXELFORMAT_ALPHA(format);
+}
+
+
+void InitPixelFormat(SDL_Window *window, SDL_Renderer *renderer)
+{
+    //Prefer the window format so textures can be copied without conversion
+    SDL_RendererInfo info;
+    Uint32 format = AddAlpha(SDL_GetWindowPixelFormat(window));
+    
+    if(SDL_GetRendererInfo(renderer, &info) == 0)
+    {
+        int supported = 0;
+        
+        for(Uint32 i = 0; i < info.num_texture_formats; i++)
+        {
+            supported |= info.texture_formats[i] == format;
+        }
+        
+        //Otherwise take the first suitable format the renderer lists
+        for(Uint32 i = 0; i < info.num_texture_formats && !supported; i++)
+        {
+            if(IsImageFormat(info.texture_formats[i]))
+            {
+                format = info.texture_formats[i];
+                supported = 1;
+            }
+        }
+        
+        if(!supported)
+        {
+            format = SDL_PIXELFORMAT_ARGB8888;
+        }
+    }
+    
+    nativeFormat = IsImageFormat(format) ? format : SDL_PIXELFORMAT_ARGB8888;
+    
+    //Use premultiplied alpha if the renderer supports the blend mode for it
+    SDL_BlendMode mode = SDL_ComposeCustomBlendMode(SDL_BLENDFACTOR_ONE, 
+        SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD, 
+        SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, 
+        SDL_BLENDOPERATION_ADD);
+    SDL_Texture *probe = SDL_CreateTexture(renderer, nativeFormat, 
+        SDL_TEXTUREACCESS_STATIC, 1, 1);
+    premultiply = probe && SDL_SetTextureBlendMode(probe, mode) == 0;
+    imageBlendMode = premultiply ? mode : SDL_BLENDMODE_BLEND;
+    
+    if(probe)
+    {
+        SDL_DestroyTexture(probe);
+    }
+    
+    SDL_Log("Image format: %s, %s alpha", 
+        SDL_GetPixelFormatName(nativeFormat), 
+        premultiply ? "premultiplied" : "straight");
+}
+
+
+Uint32 GetNativePixelFormat(void)
+{
+    return nativeFormat;
+}
+
+
+SDL_BlendMode GetImageBlendMode(void)
+{
+    return imageBlendMode;
+}
+
+
+SDL_Surface *PrepareSurface(SDL_Surface *img)
+{
+    if(!img)
+    {
+        return NULL;
+    }
+    
+    //Convert to the native format. Surfaces that wrap memory we don't own
+    //are copied too, since premultiplying writes to the pixels.
+    if(img->format->format != nativeFormat || 
+        (premultiply && (img->flags & SDL_PREALLOC)))
+    {
+        SDL_Surface *converted = SDL_ConvertSurfaceFormat(img, nativeFormat, 
+            0);
+        SDL_FreeSurface(img);
+        
+        if(!converted)
+        {
+            return NULL;
+        }
+        
+        img = converted;
+    }
+    
+    if(premultiply)
+    {
+        PremultiplyAlpha(img);
+    }
+    
+    return img;
+}
+
+
+SDL_Surface *ScaleSurface(SDL_Surface *img, int scale)
+{
+    if(!img || scale == 100)
+    {
+        return img;
+    }
+    
+    //Resample to the given size in percent with the same nearest neighbor
+    //filter the renderer would use when stretching
+    SDL_Surface *scaled = SDL_CreateRGBSurfaceWithFormat(0, 
+        SDL_max(img->w * scale / 100, 1), SDL_max(img->h * scale / 100, 1), 
+        img->format->BitsPerPixel, img->format->format);
+    
+    if(scaled)
+    {
+        SDL_SetSurfaceBlendMode(img, SDL_BLENDMODE_NONE);
+        
+        if(SDL_BlitScaled(img, NULL, scaled, NULL) == -1)
+        {
+            SDL_FreeSurface(scaled);
+            scaled = NULL;
+        }
+    }
+    
+    SDL_FreeSurface(img);
+    return scaled;
+}
+
+
+//Each kernel multiplies the color channels of 32-bit pixels by their alpha
+//and rounds the result the same way: (c * a + 127) / 255.
+static void PremultiplyRow(Uint32 *row, int count, int ashift)
+{
+    for(int i = 0; i < count; i++)
+    {
+        Uint32 pixel = row[i];
+        Uint32 a = (pixel >> ashift) & 0xFF;
+        Uint32 result = a << ashift;
+        
+        for(int shift = 0; shift < 32; shift += 8)
+        {
+            if(shift != ashift)
+            {
+                Uint32 t = ((pixel >> shift) & 0xFF) * a + 128;
+                result |= ((t + (t >> 8)) >> 8) << shift;
+            }
+        }
+        
+        row[i] = result;
+    }
+}
+
+
+#ifdef __SSE2__
+static int PremultiplyRowSSE2(Uint32 *row, int count, int ashift)
+{
+    //Do 4 pixels at a time with 16-bit intermediates
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i half = _mm_set1_epi16(128);
+    const __m128i alphaMask = _mm_set1_epi32((int)(0xFFu << ashift));
+    const __m128i shift = _mm_cvtsi32_si128(ashift);
+    int i = 0;
+    
+    for(; i + 4 <= count; i += 4)
+    {
+        __m128i pixels = _mm_loadu_si128((const __m128i*)(row + i));
+        
+        //Spread each alpha over its pixel, with 255 in the alpha byte so
+        //alpha itself comes out unchanged
+        __m128i a = _mm_and_si128(_mm_srl_epi32(pixels, shift), 
+            _mm_set1_epi32(0xFF));
+        a = _mm_or_si128(a, _mm_slli_epi32(a, 8));
+        a = _mm_or_si128(a, _mm_slli_epi32(a, 16));
+        a = _mm_or_si128(a, alphaMask);
+        
+        __m128i lo = _mm_mullo_epi16(_mm_unpacklo_epi8(pixels, zero), 
+            _mm_unpacklo_epi8(a, zero));
+        __m128i hi = _mm_mullo_epi16(_mm_unpackhi_epi8(pixels, zero), 
+            _mm_unpackhi_epi8(a, zero));
+        lo = _mm_add_epi16(lo, half);
+        hi = _mm_add_epi16(hi, half);
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+        _mm_storeu_si128((__m128i*)(row + i), _mm_packus_epi16(lo, hi));
+    }
+    
+    return i;
+}
+#endif
+
+
+#ifdef __ARM_NEON
+static int PremultiplyRowNEON(Uint32 *row, int count, int ashift)
+{
+    //Do 16 pixels at a time with the channels split into separate vectors
+    int alpha = ashift / 8;
+    int i = 0;
+    
+    for(; i + 16 <= count; i += 16)
+    {
+        uint8x16x4_t pixels = vld4q_u8((const uint8_t*)(row + i));
+        uint8x16_t a = pixels.val[alpha];
+        
+        for(int c = 0; c < 4; c++)
+        {
+            if(c == alpha)
+            {
+                continue;
+            }
+            
+            uint16x8_t lo = vmull_u8(vget_low_u8(pixels.val[c]), 
+                vget_low_u8(a));
+            uint16x8_t hi = vmull_u8(vget_high_u8(pixels.val[c]), 
+                vget_high_u8(a));
+            pixels.val[c] = vcombine_u8(
+                vraddhn_u16(lo, vrshrq_n_u16(lo, 8)), 
+                vraddhn_u16(hi, vrshrq_n_u16(hi, 8)));
+        }
+        
+        vst4q_u8((uint8_t*)(row + i), pixels);
+    }
+    
+    return i;
+}
+#endif
+
+
+void PremultiplyAlpha(SDL_Surface *surface)
+{
+    if(!IsImageFormat(surface->format->format))
+    {
+        return;
+    }
+    
+    //Pick the widest kernel the CPU supports and finish each row in C
+    int ashift = surface->format->Ashift;
+    int (*kernel)(Uint32 *row, int count, int ashift) = NULL;
+    
+    #ifdef __SSE2__
+    if(SDL_HasSSE2())
+    {
+        kernel = &PremultiplyRowSSE2;
+    }
+    #endif
+    
+    #ifdef __ARM_NEON
+    if(SDL_HasNEON())
+    {
+        kernel = &PremultiplyRowNEON;
+    }
+    #endif
+    
+    SDL_LockSurface(surface);
+    
+    for(int y = 0; y < surface->h; y++)
+    {
+        Uint32 *row = (Uint32*)((Uint8*)surface->pixels + y * surface->pitch);
+        int done = kernel ? kernel(row, surface->w, ashift) : 0;
+        PremultiplyRow(row + done, surface->w - done, ashift);
+    }
+    
+    SDL_UnlockSurface(surface);
+}
+
+
+SDL_Texture *CreateImageTexture(SDL_Renderer *renderer, SDL_Surface *img)
+{
+    //Upload the pixels as they are, since they are already in the native
+    //format
+    SDL_Texture *tex = SDL_CreateTexture(renderer, img->format->format, 
+        SDL_TEXTUREACCESS_STATIC, img->w, img->h);
+        
+    if(!tex)
+    {
+        return NULL;
+    }
+    
+    if(SDL_UpdateTexture(tex, NULL, img->pixels, img->pitch) == -1)
+    {
+        SDL_DestroyTexture(tex);
+        return NULL;
+    }
+    
+    SDL_SetTextureBlendMode(tex, imageBlendMode);
+    return tex;
+}
@@ -0,0 +1,21 @@
+/*
+SDL2 Pixel Formats
+*/
+
+#ifndef PIXELS_H
+#define PIXELS_H
+
+#include <SDL2/SDL.h>
+
+
+//Functions
+//===========================================================================
+void InitPixelFormat(SDL_Window *window, SDL_Renderer *renderer);
+Uint32 GetNativePixelFormat(void);
+SDL_BlendMode GetImageBlendMode(void);
+SDL_Surface *PrepareSurface(SDL_Surface *img);
+SDL_Surface *ScaleSurface(SDL_Surface *img, int scale);
+void PremultiplyAlpha(SDL_Surface *surface);
+SDL_Texture *CreateImageTexture(SDL_Renderer *renderer, SDL_Surface *img);
+
+#endif
@@ -0,0 +1,151 @@
+/*
+SDL2 Random Numbers
+*/
+
+#include "random.h"
+
+
+//Macros
+//===========================================================================
+#define ROTL(x, k) (((x) << (k)) | ((x) >> (64 - (k))))
+
+
+//Globals
+//===========================================================================
+static SDL_FPoint directions[360];
+
+
+//Functions
+//===========================================================================
+static Uint64 SplitMix64(Uint64 *x)
+{
+    Uint64 z = (*x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+
+static Uint64 Next64(Uint64 *s)
+{
+    Uint64 result = ROTL(s[1] * 5, 7) * 9;
+    Uint64 t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = ROTL(s[3], 45);
+    return result;
+}
+
+
+static void Jump(Uint64 *s)
+{
+    //Advance by 2^128 numbers, which gives each stream its own sequence
+    static const Uint64 jump[4] = {
+        0x180EC6D33CFD0ABAULL, 0xD5A61266F0C9392CULL, 
+        0xA9582618E03FC9AAULL, 0x39ABDC4529B1661CULL
+    };
+    Uint64 t[4] = {0, 0, 0, 0};
+    
+    for(int i = 0; i < 4; i++)
+    {
+        for(int b = 0; b < 64; b++)
+        {
+            if(jump[i] & (1ULL << b))
+            {
+                t[0] ^= s[0];
+                t[1] ^= s[1];
+                t[2] ^= s[2];
+                t[3] ^= s[3];
+            }
+            
+            Next64(s);
+        }
+    }
+    
+    SDL_memcpy(s, t, sizeof(t));
+}
+
+
+void SeedRandom(Random *rng, Uint64 seed, int stream)
+{
+    //Expand the seed into the full state, then skip ahead to the stream
+    for(int i = 0; i < 4; i++)
+    {
+        rng->state[i] = SplitMix64(&seed);
+    }
+    
+    for(int i = 0; i < stream; i++)
+    {
+        Jump(rng->state);
+    }
+    
+    rng->next = RANDOM_BATCH;
+}
+
+
+Uint32 NextRandom(Random *rng)
+{
+    //Refill the whole batch at once, two numbers per step
+    if(rng->next == RANDOM_BATCH)
+    {
+        for(int i = 0; i < RANDOM_BATCH; i += 2)
+        {
+            Uint64 x = Next64(rng->state);
+            rng->batch[i] = (Uint32)(x >> 32);
+            rng->batch[i + 1] = (Uint32)x;
+        }
+        
+        rng->next = 0;
+    }
+    
+    return rng->batch[rng->next++];
+}
+
+
+int RandomInt(Random *rng, int min, int max)
+{
+    //Returns a number in [min, max). Scaling by multiplication and throwing
+    //away the few numbers that would favor some results keeps it unbiased.
+    Uint32 range = (Uint32)(max - min);
+    
+    if(range == 0)
+    {
+        return min;
+    }
+    
+    Uint64 m = (Uint64)NextRandom(rng) * range;
+    
+    if((Uint32)m < range)
+    {
+        Uint32 threshold = (0u - range) % range;
+        
+        while((Uint32)m < threshold)
+        {
+            m = (Uint64)NextRandom(rng) * range;
+        }
+    }
+    
+    return min + (int)(m >> 32);
+}
+
+
+void InitDirectionTable(void)
+{
+    //Unit vectors for every whole degree
+    for(int i = 0; i < 360; i++)
+    {
+        double angle = i * (M_PI / 180.0);
+        directions[i].x = (float)SDL_cos(angle);
+        directions[i].y = (float)SDL_sin(angle);
+    }
+}
+
+
+const SDL_FPoint *GetDirection(int degrees)
+{
+    degrees %= 360;
+    return &directions[degrees < 0 ? degrees + 360 : degrees];
+}
@@ -0,0 +1,37 @@
+/*
+SDL2 Random Numbers
+*/
+
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <SDL2/SDL.h>
+
+
+//Macros
+//===========================================================================
+#define RANDOM_BATCH 64 //numbers generated at a time
+
+
+//Types
+//===========================================================================
+//xoshiro256** generator. Each thread should use its own, which needs no
+//locking. Seeding the same generator the same way always gives the same
+//numbers.
+typedef struct
+{
+    Uint64 state[4];
+    Uint32 batch[RANDOM_BATCH];
+    int next;                   //next unused number in batch
+} Random;
+
+
+//Functions
+//===========================================================================
+void SeedRandom(Random *rng, Uint64 seed, int stream);
+Uint32 NextRandom(Random *rng);
+int RandomInt(Random *rng, int min, int max);
+void InitDirectionTable(void);
+const SDL_FPoint *GetDirection(int degrees);
+
+#endif
@@ -0,0 +1,269 @@
+/*
+SDL2 Input Replay
+*/
+
+#include "replay.h"
+
+
+//Functions
+//===========================================================================
+static void FlushRecords(Replay *replay)
+{
+    //Write out the buffered records, and give up recording if we can't
+    if(replay->count && SDL_RWwrite(replay->file, replay->records, 
+        sizeof(ReplayRecord), replay->count) != (size_t)replay->count)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+        replay->mode = REPLAY_OFF;
+    }
+    
+    replay->count = 0;
+}
+
+
+static void WriteRecord(Replay *replay, Uint32 type, Uint32 data)
+{
+    if(replay->count == REPLAY_BUFFER_SIZE)
+    {
+        FlushRecords(replay);
+    }
+    
+    ReplayRecord *record = &replay->records[replay->count++];
+    record->tick = replay->tick;
+    record->type = type;
+    record->data = data;
+}
+
+
+static const ReplayRecord *PeekRecord(Replay *replay)
+{
+    //Refill the buffer once every record in it was used
+    if(replay->next == replay->count)
+    {
+        replay->count = (int)SDL_RWread(replay->file, replay->records, 
+            sizeof(ReplayRecord), REPLAY_BUFFER_SIZE);
+        replay->next = 0;
+    }
+    
+    return replay->next < replay->count ? &replay->records[replay->next] : 
+        NULL;
+}
+
+
+int StartRecording(Replay *replay, const char *filename, 
+    const ReplayHeader *header)
+{
+    SDL_memset(replay, 0, sizeof(*replay));
+    replay->file = SDL_RWFromFile(filename, "wb");
+    
+    if(!replay->file)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+        return 1;
+    }
+    
+    ReplayHeader out = *header;
+    out.magic = REPLAY_MAGIC;
+    out.version = REPLAY_VERSION;
+    
+    if(SDL_RWwrite(replay->file, &out, sizeof(out), 1) != 1)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+        StopReplay(replay);
+        return 1;
+    }
+    
+    SDL_Log("Recording input to %s", filename);
+    replay->mode = REPLAY_RECORD;
+    return 0;
+}
+
+
+int StartReplay(Replay *replay, const char *filename, ReplayHeader *header)
+{
+    SDL_memset(replay, 0, sizeof(*replay));
+    replay->file = SDL_RWFromFile(filename, "rb");
+    
+    if(!replay->file)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+        return 1;
+    }
+    
+    if(SDL_RWread(replay->file, header, sizeof(*header), 1) != 1 || 
+        header->magic != REPLAY_MAGIC || header->version != REPLAY_VERSION)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, 
+            "%s is not a recording this version can replay", filename);
+        StopReplay(replay);
+        return 1;
+    }
+    
+    SDL_Log("Replaying input from %s", filename);
+    replay->mode = REPLAY_PLAY;
+    return 0;
+}
+
+
+void StopReplay(Replay *replay)
+{
+    if(!replay->file)
+    {
+        return;
+    }
+    
+    //Finish the file and report how it went
+    if(replay->mode == REPLAY_RECORD)
+    {
+        FlushRecords(replay);
+        SDL_Log("Recorded %u ticks", (unsigned)replay->tick);
+    }
+    else if(replay->mode == REPLAY_PLAY && replay->mismatches)
+    {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, 
+            "Replayed %u ticks, %u diverged starting at tick %u", 
+            (unsigned)replay->tick, (unsigned)replay->mismatches, 
+            (unsigned)replay->firstMismatch);
+    }
+    else if(replay->mode == REPLAY_PLAY)
+    {
+        SDL_Log("Replayed %u ticks, all checksums matched", 
+            (unsigned)replay->tick);
+    }
+    
+    if(SDL_RWclose(replay->file) == -1)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+    }
+    
+    SDL_memset(replay, 0, sizeof(*replay));
+}
+
+
+void RecordEvent(Replay *replay, const SDL_Event *event)
+{
+    if(replay->mode != REPLAY_RECORD)
+    {
+        return;
+    }
+    
+    //Only mouse events are kept, and of those only the position
+    Sint32 x;
+    Sint32 y;
+    
+    switch(event->type)
+    {
+    case SDL_MOUSEBUTTONDOWN:
+    case SDL_MOUSEBUTTONUP:
+        x = event->button.x;
+        y = event->button.y;
+        break;
+        
+    case SDL_MOUSEMOTION:
+        x = event->motion.x;
+        y = event->motion.y;
+        break;
+        
+    default:
+        return;
+    }
+    
+    WriteRecord(replay, event->type, (Uint16)x | (Uint32)(Uint16)y << 16);
+}
+
+
+int ReplayEvent(Replay *replay, SDL_Event *event)
+{
+    if(replay->mode != REPLAY_PLAY)
+    {
+        return 0;
+    }
+    
+    //Hand out the events recorded for the current tick one at a time
+    const ReplayRecord *record = PeekRecord(replay);
+    
+    if(!record || record->tick != replay->tick || 
+        record->type == REPLAY_CHECKSUM)
+    {
+        return 0;
+    }
+    
+    replay->next++;
+    Sint32 x = (Sint16)(record->data & 0xFFFF);
+    Sint32 y = (Sint16)(record->data >> 16);
+    SDL_memset(event, 0, sizeof(*event));
+    event->type = record->type;
+    event->common.timestamp = SDL_GetTicks();
+    
+    if(record->type == SDL_MOUSEMOTION)
+    {
+        event->motion.x = x;
+        event->motion.y = y;
+    }
+    else
+    {
+        event->button.button = SDL_BUTTON_LEFT;
+        event->button.state = record->type == SDL_MOUSEBUTTONDOWN ? 
+            SDL_PRESSED : SDL_RELEASED;
+        event->button.clicks = 1;
+        event->button.x = x;
+        event->button.y = y;
+    }
+    
+    return 1;
+}
+
+
+void EndReplayTick(Replay *replay, Uint32 checksum)
+{
+    if(replay->mode == REPLAY_RECORD)
+    {
+        WriteRecord(replay, REPLAY_CHECKSUM, checksum);
+        replay->tick++;
+        return;
+    }
+    
+    if(replay->mode != REPLAY_PLAY || SDL_AtomicGet(&replay->done))
+    {
+        return;
+    }
+    
+    //Skip events that weren't asked for and find this tick's checksum
+    const ReplayRecord *record;
+    
+    while((record = PeekRecord(replay)) && record->tick <= replay->tick && 
+        record->type != REPLAY_CHECKSUM)
+    {
+        replay->next++;
+    }
+    
+    if(!record)
+    {
+        SDL_AtomicSet(&replay->done, 1);
+        return;
+    }
+    
+    if(record->tick == replay->tick)
+    {
+        replay->next++;
+        
+        //Only report the first divergence, since every later tick is likely
+        //to differ too
+        if(record->data != checksum && !replay->mismatches++)
+        {
+            replay->firstMismatch = replay->tick;
+            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, 
+                "Replay diverged at tick %u (checksum %08x, expected %08x)", 
+                (unsigned)replay->tick, (unsigned)checksum, 
+                (unsigned)record->data);
+        }
+    }
+    
+    replay->tick++;
+}
+
+
+int IsReplayDone(Replay *replay)
+{
+    return SDL_AtomicGet(&replay->done);
+}
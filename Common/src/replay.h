@@ -0,0 +1,79 @@
+/*
+SDL2 Input Replay
+*/
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <SDL2/SDL.h>
+
+
+//Macros
+//===========================================================================
+#define REPLAY_MAGIC       0x50455253 //"SREP"
+#define REPLAY_VERSION     2
+#define REPLAY_BUFFER_SIZE 256        //records read or written at once
+#define REPLAY_CHECKSUM    0          //record type of a tick's checksum
+
+
+//Types
+//===========================================================================
+typedef enum
+{
+    REPLAY_OFF,
+    REPLAY_RECORD,
+    REPLAY_PLAY
+} ReplayMode;
+
+
+//Like asset packs, recordings are stored in the byte order of the machine
+//that wrote them.
+typedef struct
+{
+    Uint32 magic;
+    Uint32 version;
+    Uint32 seed;          //what the simulation started from
+    Sint32 bubbles;
+    Sint32 maxBubbles;
+    Sint32 width;         //area the bubbles move in
+    Sint32 height;
+    Sint32 tickRate;
+} ReplayHeader;
+
+
+//Each tick is stored as the mouse events the simulation saw during it,
+//followed by a checksum of the state it ended with.
+typedef struct
+{
+    Uint32 tick;
+    Uint32 type;          //SDL event type or REPLAY_CHECKSUM
+    Uint32 data;          //x and y in the low and high half, or the checksum
+} ReplayRecord;
+
+
+typedef struct
+{
+    ReplayMode mode;
+    SDL_RWops *file;
+    ReplayRecord records[REPLAY_BUFFER_SIZE];
+    int count;            //records in the buffer
+    int next;             //next buffered record to replay
+    Uint32 tick;
+    Uint32 mismatches;    //ticks whose checksum differed
+    Uint32 firstMismatch;
+    SDL_atomic_t done;    //set once a replay runs out of records
+} Replay;
+
+
+//Functions
+//===========================================================================
+int StartRecording(Replay *replay, const char *filename, 
+    const ReplayHeader *header);
+int StartReplay(Replay *replay, const char *filename, ReplayHeader *header);
+void StopReplay(Replay *replay);
+void RecordEvent(Replay *replay, const SDL_Event *event);
+int ReplayEvent(Replay *replay, SDL_Event *event);
+void EndReplayTick(Replay *replay, Uint32 checksum);
+int IsReplayDone(Replay *replay);
+
+#endif
@@ -0,0 +1,607 @@
+/*
+SDL2 Bubble Simulation
+*/
+
+#include "simulation.h"
+#include "events.h"
+#include "grid.h"
+#include "jobs.h"
+#include "random.h"
+#include "replay.h"
+#include "telemetry.h"
+#include "timestep.h"
+#include "triplebuffer.h"
+
+
+//Macros
+//===========================================================================
+#ifndef TRUE
+    #define TRUE  1
+    #define FALSE 0
+#endif
+
+#define TICK_RATE  60
+#define JOB_GRAIN  1024 //bubbles per simulation job
+#define SPAWN_TIME 60   //ticks between new bubbles
+#define POP_TIME   30   //ticks a popped bubble stays visible
+
+
+//Types
+//===========================================================================
+typedef struct
+{
+    SDL_SpinLock lock;
+    SDL_Point pos;
+    int visible;
+    Uint32 time;
+} PinInput;
+
+
+//Globals
+//===========================================================================
+static FixedTimestep timestep;
+static Random rng;
+static Replay replay;
+
+static PinInput pinInput;
+static TripleBuffer snapshots;
+static SDL_Thread *simThread = NULL;
+static SDL_atomic_t simRunning;
+
+static SDL_Point areaSize;
+static Pin pin;
+
+static int maxBubbles = 0;
+static int spawnTmr = SPAWN_TIME;
+static SDL_Rect bubbleSize;
+static BubbleStore bubbles;
+static SpatialGrid bubbleGrid;
+static GridPairList contacts;
+static Uint32 popInputTime = 0;
+static Uint32 pops = 0;
+static Uint32 pinPops = 0;
+
+
+//Functions
+//===========================================================================
+static int SDLCALL SimulationThread(void *data);
+
+
+int InitSimulationReplay(Options *options, SDL_Point *area)
+{
+    ReplayHeader header;
+    
+    //Replays start from the seed, bubble counts and area they were
+    //recorded with
+    if(options->replayFile)
+    {
+        if(StartReplay(&replay, options->replayFile, &header))
+        {
+            return 1;
+        }
+        
+        if(header.tickRate != TICK_RATE)
+        {
+            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, 
+                "Recorded at %i ticks per second instead of %i.", 
+                (int)header.tickRate, TICK_RATE);
+        }
+        
+        options->seed = header.seed;
+        options->bubbles = header.bubbles;
+        options->maxBubbles = header.maxBubbles;
+        area->x = header.width;
+        area->y = header.height;
+        return 0;
+    }
+    
+    //Otherwise save them along with the input if asked to
+    if(options->recordFile)
+    {
+        SDL_memset(&header, 0, sizeof(header));
+        header.seed = options->seed;
+        header.bubbles = options->bubbles;
+        header.maxBubbles = options->maxBubbles;
+        header.width = area->x;
+        header.height = area->y;
+        header.tickRate = TICK_RATE;
+        return StartRecording(&replay, options->recordFile, &header);
+    }
+    
+    return 0;
+}
+
+
+static int CreateBubble(void)
+{
+    //Spawn a bubble at a random position, heading in a random direction
+    float x = RandomInt(&rng, 0, areaSize.x - bubbleSize.w);
+    float y = RandomInt(&rng, 0, areaSize.y - bubbleSize.h);
+    float vx = GetDirection(RandomInt(&rng, 0, 360))->x;
+    float vy = GetDirection(RandomInt(&rng, 0, 360))->y;
+    return AddBubble(&bubbles, x, y, vx, vy, 100);
+}
+
+
+int InitSimulation(const Options *options, const SDL_Point *area, 
+    const SDL_Rect *bubbleRect, const SDL_Rect *pinRect)
+{
+    areaSize = *area;
+    bubbleSize = *bubbleRect;
+    pin.rect = *pinRect;
+    maxBubbles = options->maxBubbles;
+    
+    //Init random numbers
+    SeedRandom(&rng, options->seed, 0);
+    InitDirectionTable();
+    
+    //Allocate bubble storage
+    if(InitBubbleStore(&bubbles, maxBubbles))
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+        return 1;
+    }
+    
+    //Init the collision grid with cells as large as a bubble
+    if(InitSpatialGrid(&bubbleGrid, areaSize.x, areaSize.y, 
+        SDL_max(bubbleSize.w, bubbleSize.h), maxBubbles))
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+        return 1;
+    }
+    
+    //Spawn the initial bubbles
+    for(int i = 0; i < options->bubbles; i++)
+    {
+        if(CreateBubble() == -1)
+        {
+            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, 
+                "Only room for %i bubbles.", i);
+            break;
+        }
+    }
+    
+    return 0;
+}
+
+
+static void PublishSnapshot(void)
+{
+    //Copy the simulation state into the back buffer and publish it
+    Snapshot *snapshot = (Snapshot*)GetWriteBuffer(&snapshots);
+    snapshot->pin = pin;
+    SnapshotBubbles(&snapshot->bubbles, &bubbles);
+    snapshot->popInputTime = popInputTime;
+    snapshot->pops = pops;
+    snapshot->pinPops = pinPops;
+    snapshot->time = SDL_GetPerformanceCounter();
+    PublishWriteBuffer(&snapshots);
+}
+
+
+int StartSimulation(int lockstep)
+{
+    //Step at a fixed rate, or once per frame in lockstep mode
+    InitTimestep(&timestep, TICK_RATE);
+    
+    if(SetTimestepLockstep(&timestep, lockstep))
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+        return 1;
+    }
+    
+    //Create the snapshot buffers and publish the initial state
+    if(InitTripleBuffer(&snapshots, sizeof(Snapshot)))
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+        return 1;
+    }
+    
+    //Each snapshot gets its own copy of the bubbles
+    for(int i = 0; i < 3; i++)
+    {
+        Snapshot *snapshot = (Snapshot*)snapshots.buffers[i];
+        
+        if(InitBubbleStore(&snapshot->bubbles, maxBubbles))
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+            return 1;
+        }
+    }
+    
+    PublishSnapshot();
+    
+    //Start the simulation thread
+    SDL_AtomicSet(&simRunning, TRUE);
+    simThread = SDL_CreateThread(&SimulationThread, "Simulation", NULL);
+    
+    if(!simThread)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+        return 1;
+    }
+    
+    return 0;
+}
+
+
+void FreeSimulation(void)
+{
+    //Wait for the simulation thread to finish
+    if(simThread)
+    {
+        SDL_AtomicSet(&simRunning, FALSE);
+        AllowNextStep(&timestep);
+        SDL_WaitThread(simThread, NULL);
+        simThread = NULL;
+    }
+    
+    FreeTimestep(&timestep);
+    
+    for(int i = 0; i < 3; i++)
+    {
+        if(snapshots.buffers[i])
+        {
+            FreeBubbleStore(&((Snapshot*)snapshots.buffers[i])->bubbles);
+        }
+    }
+    
+    FreeTripleBuffer(&snapshots);
+    
+    //Finish the recording or replay
+    StopReplay(&replay);
+    
+    //Free bubbles and their collision data
+    FreeBubbleStore(&bubbles);
+    FreeSpatialGrid(&bubbleGrid);
+    FreeGridPairList(&contacts);
+}
+
+
+const Snapshot *GetSimulationSnapshot(int last)
+{
+    //Grab the latest snapshot. In lockstep mode that is the step allowed
+    //for this frame, and the simulation starts on the next one while the
+    //frame is drawn, unless this is the last frame.
+    WaitForStepDone(&timestep);
+    const Snapshot *snapshot = (const Snapshot*)GetReadBuffer(&snapshots);
+    
+    if(!last)
+    {
+        AllowNextStep(&timestep);
+    }
+    
+    return snapshot;
+}
+
+
+float GetSnapshotAlpha(const Snapshot *snapshot)
+{
+    //How far we are between the snapshot's step and the next one
+    float alpha = (float)(SDL_GetPerformanceCounter() - snapshot->time) * 
+        TICK_RATE / SDL_GetPerformanceFrequency();
+    return SDL_min(alpha, 1.0f);
+}
+
+
+static void SetPinPos(int x, int y, Uint32 time)
+{
+    //Pass the new position on to the simulation thread
+    SDL_AtomicLock(&pinInput.lock);
+    pinInput.pos.x = x;
+    pinInput.pos.y = y;
+    pinInput.time = time;
+    SDL_AtomicUnlock(&pinInput.lock);
+}
+
+
+static void ShowPin(int doShow, Uint32 time)
+{
+    //Pass the new visibility on to the simulation thread
+    SDL_AtomicLock(&pinInput.lock);
+    pinInput.visible = doShow;
+    pinInput.time = time;
+    SDL_AtomicUnlock(&pinInput.lock);
+}
+
+
+void HandlePinEvent(const SDL_Event *event)
+{
+    //Move, show or hide the pin
+    switch(event->type)
+    {
+        //Mouse Button Down Event
+    case SDL_MOUSEBUTTONDOWN:
+        ShowPin(TRUE, event->button.timestamp);
+        SetPinPos(event->button.x, event->button.y, event->button.timestamp);
+        break;
+        
+        //Mouse Button Up Event
+    case SDL_MOUSEBUTTONUP:
+        ShowPin(FALSE, event->button.timestamp);
+        break;
+        
+        //Mouse Motion Event
+    case SDL_MOUSEMOTION:
+        SetPinPos(event->motion.x, event->motion.y, event->motion.timestamp);
+        break;
+    }
+}
+
+
+void LatchPin(Pin *pinState)
+{
+    //Sample the mouse again right before the pin is drawn
+    int x;
+    int y;
+    SDL_PumpEvents();
+    Uint32 buttons = SDL_GetMouseState(&x, &y);
+    Uint32 time = GetLastInputTime();
+    
+    //Draw the pin there and hand the sample to the simulation right away
+    //instead of waiting for the next frame's events
+    pinState->visible = buttons != 0;
+    pinState->rect.x = x;
+    pinState->rect.y = y;
+    pinState->inputTime = time;
+    SetPinPos(x, y, time);
+    ShowPin(buttons != 0, time);
+}
+
+
+int IsSimulationReplaying(void)
+{
+    return replay.mode == REPLAY_PLAY;
+}
+
+
+int IsSimulationDone(void)
+{
+    //Replays end when they run out of input
+    return IsReplayDone(&replay);
+}
+
+
+static void RecordPin(const Pin *last)
+{
+    //Record the events that turn the last tick's pin into this one
+    SDL_Event event;
+    SDL_memset(&event, 0, sizeof(event));
+    
+    if(pin.rect.x != last->rect.x || pin.rect.y != last->rect.y)
+    {
+        event.type = SDL_MOUSEMOTION;
+        event.motion.x = pin.rect.x;
+        event.motion.y = pin.rect.y;
+        RecordEvent(&replay, &event);
+    }
+    
+    if(pin.visible != last->visible)
+    {
+        event.type = pin.visible ? SDL_MOUSEBUTTONDOWN : SDL_MOUSEBUTTONUP;
+        event.button.x = pin.rect.x;
+        event.button.y = pin.rect.y;
+        RecordEvent(&replay, &event);
+    }
+}
+
+
+static void UpdatePin(void)
+{
+    //Replays feed the recorded events through the usual event handling on
+    //the tick they were recorded on
+    SDL_Event event;
+    
+    while(ReplayEvent(&replay, &event))
+    {
+        HandlePinEvent(&event);
+    }
+    
+    //Apply the latest input from the main thread
+    Pin last = pin;
+    SDL_AtomicLock(&pinInput.lock);
+    pin.rect.x = pinInput.pos.x;
+    pin.rect.y = pinInput.pos.y;
+    pin.visible = pinInput.visible;
+    pin.inputTime = pinInput.time;
+    SDL_AtomicUnlock(&pinInput.lock);
+    
+    //The simulation only sees the input it picks up here, so that is what
+    //gets recorded
+    if(replay.mode == REPLAY_RECORD)
+    {
+        RecordPin(&last);
+    }
+}
+
+
+static void SpawnBubble(void)
+{
+    //Update spawn timer
+    if(spawnTmr--)
+    {
+        return;
+    }
+    
+    //Reset spawn timer
+    spawnTmr = SPAWN_TIME;
+    
+    //Spawn a bubble
+    CreateBubble();
+}
+
+
+static void PopBubble(int i)
+{
+    //The demos pick up the pop count from the snapshot
+    BurstBubble(&bubbles, i, POP_TIME);
+    pops++;
+}
+
+
+static void GetBubbleCenter(int i, SDL_Point *p)
+{
+    p->x = (int)bubbles.x[i] + bubbleSize.w / 2;
+    p->y = (int)bubbles.y[i] + bubbleSize.h / 2;
+}
+
+
+static void HitBubbleWithPin(int id, void *data)
+{
+    //Pop the bubble if the pin touches it
+    SDL_Rect rect = bubbleSize;
+    rect.x = bubbles.x[id];
+    rect.y = bubbles.y[id];
+    
+    if(bubbles.state[id] == BUBBLE_ACTIVE && 
+        SDL_HasIntersection(&rect, &pin.rect))
+    {
+        PopBubble(id);
+        pinPops++;
+        popInputTime = pin.inputTime;
+    }
+}
+
+
+static int BubblesTouch(int a, int b, void *data)
+{
+    //Only active bubbles collide
+    if(bubbles.state[a] != BUBBLE_ACTIVE || bubbles.state[b] != BUBBLE_ACTIVE)
+    {
+        return FALSE;
+    }
+    
+    //Compare squared distances to avoid a sqrt
+    SDL_Point p1;
+    SDL_Point p2;
+    GetBubbleCenter(a, &p1);
+    GetBubbleCenter(b, &p2);
+    
+    int dx = p2.x - p1.x;
+    int dy = p2.y - p1.y;
+    int reach = bubbleSize.w / 2 + bubbleSize.h / 2;
+    return dx * dx + dy * dy < reach * reach;
+}
+
+
+static void BounceBubbles(int a, int b)
+{
+    //Either bubble may have popped earlier in this step
+    if(bubbles.state[a] != BUBBLE_ACTIVE || bubbles.state[b] != BUBBLE_ACTIVE)
+    {
+        return;
+    }
+    
+    bubbles.vx[a] = -bubbles.vx[a];
+    bubbles.vy[a] = -bubbles.vy[a];
+    
+    if(--bubbles.hp[a] == 0)
+    {
+        PopBubble(a);
+    }
+    
+    bubbles.vx[b] = -bubbles.vx[b];
+    bubbles.vy[b] = -bubbles.vy[b];
+    
+    if(--bubbles.hp[b] == 0)
+    {
+        PopBubble(b);
+    }
+}
+
+
+static void BinBubbles(void *data, int start, int end)
+{
+    //Put each bubble in the grid cell its center is in
+    for(int i = start; i < end; i++)
+    {
+        SDL_Point p;
+        GetBubbleCenter(i, &p);
+        SetSpatialGridItem(&bubbleGrid, i, i, p.x, p.y);
+    }
+}
+
+
+static void CollideBubbles(void)
+{
+    //Sort the bubbles into the grid in parallel
+    SetSpatialGridCount(&bubbleGrid, bubbles.count);
+    ParallelFor(&BinBubbles, NULL, bubbles.count, JOB_GRAIN);
+    SortSpatialGrid(&bubbleGrid);
+    
+    //Pop the bubbles under the pin
+    if(pin.visible)
+    {
+        QuerySpatialGrid(&bubbleGrid, &pin.rect, &HitBubbleWithPin, NULL);
+    }
+    
+    //Find the touching pairs in parallel, then bounce them in cell order so
+    //the result doesn't depend on thread timing
+    CollectGridPairs(&bubbleGrid, &BubblesTouch, NULL, &contacts);
+    
+    for(int i = 0; i < contacts.count; i++)
+    {
+        BounceBubbles(contacts.pairs[i * 2], contacts.pairs[i * 2 + 1]);
+    }
+}
+
+
+static Uint32 ChecksumSimulation(void)
+{
+    //Besides the bubbles, the next step depends on the spawn timer, the pin
+    //and how far the random number generator has got
+    Uint32 state[13];
+    state[0] = (Uint32)spawnTmr;
+    state[1] = (Uint32)pin.rect.x;
+    state[2] = (Uint32)pin.rect.y;
+    state[3] = pin.visible != 0;
+    state[4] = (Uint32)rng.next;
+    
+    for(int i = 0; i < 4; i++)
+    {
+        state[5 + i * 2] = (Uint32)rng.state[i];
+        state[6 + i * 2] = (Uint32)(rng.state[i] >> 32);
+    }
+    
+    return ChecksumBubbles(&bubbles, state, 13);
+}
+
+
+static int SDLCALL SimulationThread(void *data)
+{
+    //Run the simulation at a fixed rate until told to stop
+    while(SDL_AtomicGet(&simRunning))
+    {
+        BeginTimestep(&timestep);
+        Uint64 start = SDL_GetPerformanceCounter();
+        int steps = 0;
+        
+        while(StepTimestep(&timestep))
+        {
+            UpdatePin();
+            SpawnBubble();
+            CollideBubbles();
+            MoveBubbles(&bubbles, areaSize.x - bubbleSize.w, 
+                areaSize.y - bubbleSize.h);
+            
+            //Check or record the outcome of this tick
+            if(replay.mode != REPLAY_OFF)
+            {
+                EndReplayTick(&replay, ChecksumSimulation());
+            }
+            
+            steps++;
+        }
+        
+        //Publish the result and wait for the next step
+        if(steps)
+        {
+            PublishSnapshot();
+            RecordTelemetrySince(TELEMETRY_UPDATE, start);
+        }
+        
+        WaitForNextStep(&timestep);
+    }
+    
+    return 0;
+}
@@ -0,0 +1,50 @@
+/*
+SDL2 Bubble Simulation
+*/
+
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <SDL2/SDL.h>
+
+#include "bubbles.h"
+#include "options.h"
+
+
+//Types
+//===========================================================================
+typedef struct
+{
+    SDL_Rect rect;
+    int visible;
+    Uint32 inputTime;      //when the input that put the pin here happened
+} Pin;
+
+
+//Everything the render loop needs to draw one simulation step
+typedef struct
+{
+    Pin pin;
+    BubbleStore bubbles;
+    Uint32 popInputTime;   //input time of the pin's last pop
+    Uint32 pops;           //bubbles popped so far
+    Uint32 pinPops;        //the ones of those popped by the pin
+    Uint64 time;           //when the step was published
+} Snapshot;
+
+
+//Functions
+//===========================================================================
+int InitSimulationReplay(Options *options, SDL_Point *area);
+int InitSimulation(const Options *options, const SDL_Point *area, 
+    const SDL_Rect *bubbleRect, const SDL_Rect *pinRect);
+int StartSimulation(int lockstep);
+void FreeSimulation(void);
+const Snapshot *GetSimulationSnapshot(int last);
+float GetSnapshotAlpha(const Snapshot *snapshot);
+void HandlePinEvent(const SDL_Event *event);
+void LatchPin(Pin *pin);
+int IsSimulationReplaying(void);
+int IsSimulationDone(void);
+
+#endif
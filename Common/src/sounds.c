@@ -0,0 +1,144 @@
+/*
+SDL2 Sound Events
+*/
+
+#include "audio.h"
+#include "sounds.h"
+
+
+//Types
+//===========================================================================
+typedef struct
+{
+    Mix_Chunk *chunk;
+    int priority;
+    int count;        //times the sound was triggered this frame
+} SoundTrigger;
+
+
+typedef struct
+{
+    int priority;
+    Uint32 start;
+} Voice;
+
+
+//Globals
+//===========================================================================
+static SoundTrigger triggers[MAX_SOUND_TRIGGERS];
+static int triggerCount = 0;
+static Voice voices[MAX_VOICES];
+static int voiceCount = 0;
+
+
+//Functions
+//===========================================================================
+void InitSounds(int count)
+{
+    //Every voice costs mixer time whether it is audible or not, so the
+    //number of voices is what bounds the cost of audio
+    voiceCount = count > 0 ? SDL_min(count, MAX_VOICES) : DEFAULT_VOICES;
+    voiceCount = AllocateVoices(voiceCount);
+    triggerCount = 0;
+    SDL_memset(voices, 0, sizeof(voices));
+}
+
+
+void TriggerSound(Mix_Chunk *chunk, int priority)
+{
+    //Triggering a sound that is already due this frame just makes it louder
+    for(int i = 0; i < triggerCount; i++)
+    {
+        if(triggers[i].chunk == chunk)
+        {
+            triggers[i].priority = SDL_max(triggers[i].priority, priority);
+            triggers[i].count++;
+            return;
+        }
+    }
+    
+    if(triggerCount == MAX_SOUND_TRIGGERS)
+    {
+        return;
+    }
+    
+    SoundTrigger *trigger = &triggers[triggerCount++];
+    trigger->chunk = chunk;
+    trigger->priority = priority;
+    trigger->count = 1;
+}
+
+
+static int FindVoice(int priority)
+{
+    //Take a free voice if there is one. Otherwise steal the oldest of the
+    //least important voices, unless even that matters more than the new
+    //sound.
+    int victim = -1;
+    
+    for(int i = 0; i < voiceCount; i++)
+    {
+        if(!IsVoicePlaying(i))
+        {
+            return i;
+        }
+        
+        if(victim == -1 || voices[i].priority < voices[victim].priority || 
+            (voices[i].priority == voices[victim].priority && 
+            SDL_TICKS_PASSED(voices[victim].start, voices[i].start)))
+        {
+            victim = i;
+        }
+    }
+    
+    if(victim == -1 || voices[victim].priority > priority)
+    {
+        return -1;
+    }
+    
+    StopVoice(victim);
+    return victim;
+}
+
+
+void FlushSounds(void)
+{
+    //Hand out voices to the most important sounds first
+    for(int i = 1; i < triggerCount; i++)
+    {
+        SoundTrigger trigger = triggers[i];
+        int j = i;
+        
+        for(; j > 0 && triggers[j - 1].priority < trigger.priority; j--)
+        {
+            triggers[j] = triggers[j - 1];
+        }
+        
+        triggers[j] = trigger;
+    }
+    
+    Uint32 now = SDL_GetTicks();
+    
+    for(int i = 0; i < triggerCount; i++)
+    {
+        int channel = FindVoice(triggers[i].priority);
+        
+        if(channel == -1)
+        {
+            continue;
+        }
+        
+        //Identical sounds started together add up like uncorrelated noise,
+        //so a merged voice gets louder by the square root of their number
+        float gain = SDL_sqrtf((float)triggers[i].count);
+        int volume = SDL_min((int)(SOUND_VOLUME * gain), MIX_MAX_VOLUME);
+        
+        if(PlayAudioChunk(channel, triggers[i].chunk, volume) != -1)
+        {
+            voices[channel].priority = triggers[i].priority;
+            voices[channel].start = now;
+        }
+    }
+    
+    triggerCount = 0;
+}
@@ -0,0 +1,26 @@
+/*
+SDL2 Sound Events
+*/
+
+#ifndef SOUNDS_H
+#define SOUNDS_H
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_mixer.h>
+
+
+//Macros
+//===========================================================================
+#define MAX_SOUND_TRIGGERS 16  //different sounds started per frame
+#define MAX_VOICES         64
+#define DEFAULT_VOICES     8
+#define SOUND_VOLUME       (MIX_MAX_VOLUME / 2) //volume of a single trigger
+
+
+//Functions
+//===========================================================================
+void InitSounds(int count);
+void TriggerSound(Mix_Chunk *chunk, int priority);
+void FlushSounds(void);
+
+#endif
@@ -0,0 +1,557 @@
+/*
+SDL2 Sound Streams
+*/
+
+#include "stream.h"
+
+
+//Macros
+//===========================================================================
+#define WAV_RIFF       0x46464952 //"RIFF"
+#define WAV_WAVE       0x45564157 //"WAVE"
+#define WAV_FMT        0x20746D66 //"fmt "
+#define WAV_DATA       0x61746164 //"data"
+#define WAV_PCM        1          //format tags
+#define WAV_FLOAT      3
+#define WAV_EXTENSIBLE 0xFFFE
+#define OGG_MAGIC      0x5367674F //"OggS"
+
+
+//Globals
+//===========================================================================
+//Every SubFormat GUID of an extensible WAV ends like this, after the two
+//bytes that hold the real format tag
+static const Uint8 wavGuidTail[14] = {
+    0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 
+    0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71
+};
+
+
+//Functions
+//===========================================================================
+static int SDLCALL ReaderThread(void *data);
+
+
+static int OpenWav(SoundStream *stream, SDL_AudioSpec *spec)
+{
+    //Walk the chunks of the file up to the samples, which are left for the
+    //reader thread
+    Uint32 header[3];
+    int haveFormat = 0;
+    
+    if(SDL_RWread(stream->file, header, sizeof(header), 1) != 1 || 
+        SDL_SwapLE32(header[0]) != WAV_RIFF || 
+        SDL_SwapLE32(header[2]) != WAV_WAVE)
+    {
+        return 1;
+    }
+    
+    for(;;)
+    {
+        Uint32 chunk[2];
+        
+        if(SDL_RWread(stream->file, chunk, sizeof(chunk), 1) != 1)
+        {
+            return 1;
+        }
+        
+        Uint32 id = SDL_SwapLE32(chunk[0]);
+        Uint32 size = SDL_SwapLE32(chunk[1]);
+        
+        if(id == WAV_DATA && haveFormat)
+        {
+            stream->dataStart = SDL_RWtell(stream->file);
+            stream->dataSize = size - size % stream->frameSize;
+            stream->dataLeft = stream->dataSize;
+            return stream->dataSize ? 0 : 1;
+        }
+        
+        if(id == WAV_FMT && size >= 16)
+        {
+            Uint16 format[8];
+            
+            if(SDL_RWread(stream->file, format, sizeof(format), 1) != 1)
+            {
+                return 1;
+            }
+            
+            Uint16 tag = SDL_SwapLE16(format[0]);
+            Uint16 bits = SDL_SwapLE16(format[7]);
+            spec->channels = (Uint8)SDL_SwapLE16(format[1]);
+            spec->freq = (int)(SDL_SwapLE16(format[2]) | 
+                (Uint32)SDL_SwapLE16(format[3]) << 16);
+            size -= 16;
+            
+            //Extensible files keep the real format tag at the start of the
+            //SubFormat GUID
+            if(tag == WAV_EXTENSIBLE)
+            {
+                Uint8 extension[24];
+                
+                if(size < sizeof(extension) || SDL_RWread(stream->file, 
+                    extension, sizeof(extension), 1) != 1 || 
+                    (extension[0] | extension[1] << 8) < 22 || 
+                    SDL_memcmp(extension + 10, wavGuidTail, 
+                    sizeof(wavGuidTail)) != 0)
+                {
+                    return 1;
+                }
+                
+                tag = (Uint16)(extension[8] | extension[9] << 8);
+                size -= sizeof(extension);
+            }
+            
+            //Compressed formats are left to SDL_mixer
+            if(tag == WAV_PCM && bits == 8)
+            {
+                spec->format = AUDIO_U8;
+            }
+            else if(tag == WAV_PCM && bits == 16)
+            {
+                spec->format = AUDIO_S16LSB;
+            }
+            else if(tag == WAV_PCM && bits == 32)
+            {
+                spec->format = AUDIO_S32LSB;
+            }
+            else if(tag == WAV_FLOAT && bits == 32)
+            {
+                spec->format = AUDIO_F32LSB;
+            }
+            else
+            {
+                return 1;
+            }
+            
+            if(!spec->channels || !spec->freq)
+            {
+                return 1;
+            }
+            
+            stream->frameSize = spec->channels * bits / 8;
+            haveFormat = 1;
+        }
+        
+        //Chunks are padded to an even size
+        if(SDL_RWseek(stream->file, size + (size & 1), RW_SEEK_CUR) < 0)
+        {
+            return 1;
+        }
+    }
+}
+
+
+#ifdef USE_VORBISFILE
+static size_t ReadVorbis(void *ptr, size_t size, size_t count, void *file)
+{
+    return SDL_RWread((SDL_RWops*)file, ptr, size, count);
+}
+
+
+static int SeekVorbis(void *file, ogg_int64_t offset, int whence)
+{
+    //SEEK_SET, SEEK_CUR and SEEK_END have the same values as SDL's
+    return SDL_RWseek((SDL_RWops*)file, offset, whence) < 0 ? -1 : 0;
+}
+
+
+static long TellVorbis(void *file)
+{
+    return (long)SDL_RWtell((SDL_RWops*)file);
+}
+
+
+static int OpenVorbis(SoundStream *stream, SDL_AudioSpec *spec)
+{
+    //The file is closed by us rather than by libvorbisfile
+    ov_callbacks callbacks = {&ReadVorbis, &SeekVorbis, NULL, &TellVorbis};
+    
+    if(ov_open_callbacks(stream->file, &stream->vorbisFile, NULL, 0, 
+        callbacks) != 0)
+    {
+        return 1;
+    }
+    
+    stream->vorbis = 1;
+    vorbis_info *info = ov_info(&stream->vorbisFile, -1);
+    spec->format = AUDIO_S16SYS;
+    spec->channels = (Uint8)info->channels;
+    spec->freq = (int)info->rate;
+    stream->frameSize = info->channels * 2;
+    return 0;
+}
+#endif
+
+
+static int ReadRaw(SoundStream *stream, Uint8 *dest, int size)
+{
+    #ifdef USE_VORBISFILE
+    if(stream->vorbis)
+    {
+        //Holes in the data aren't worth stopping for
+        int section;
+        long got;
+        
+        do
+        {
+            got = ov_read(&stream->vorbisFile, (char*)dest, size, 
+                SDL_BYTEORDER == SDL_BIG_ENDIAN, 2, 1, &section);
+        } while(got == OV_HOLE);
+        
+        return got > 0 ? (int)got : 0;
+    }
+    #endif
+    
+    //Only ever hand the converter whole frames
+    Uint32 want = SDL_min((Uint32)(size - size % stream->frameSize), 
+        stream->dataLeft);
+    size_t got = want ? SDL_RWread(stream->file, dest, 1, want) : 0;
+    got -= got % stream->frameSize;
+    stream->dataLeft -= (Uint32)got;
+    return (int)got;
+}
+
+
+static int RewindStream(SoundStream *stream)
+{
+    #ifdef USE_VORBISFILE
+    if(stream->vorbis)
+    {
+        return ov_pcm_seek(&stream->vorbisFile, 0) != 0;
+    }
+    #endif
+    
+    stream->dataLeft = stream->dataSize;
+    return SDL_RWseek(stream->file, stream->dataStart, RW_SEEK_SET) < 0;
+}
+
+
+static int DecodeStream(SoundStream *stream, Uint8 *dest, int size)
+{
+    Uint8 raw[STREAM_READ_SIZE];
+    int progress = 1;
+    
+    //Keep the converter fed until it has a whole buffer for us
+    while(SDL_AudioStreamAvailable(stream->convert) < size)
+    {
+        int got = ReadRaw(stream, raw, STREAM_READ_SIZE);
+        
+        if(got > 0)
+        {
+            SDL_AudioStreamPut(stream->convert, raw, got);
+            progress = 1;
+            continue;
+        }
+        
+        //Start over at the end of a looping sound, unless starting over
+        //didn't give us anything either
+        if(stream->loop && progress && RewindStream(stream) == 0)
+        {
+            progress = 0;
+            continue;
+        }
+        
+        SDL_AudioStreamFlush(stream->convert);
+        break;
+    }
+    
+    int got = SDL_AudioStreamGet(stream->convert, dest, size);
+    
+    if(got < 0)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+    }
+    
+    return got;
+}
+
+
+static void StopStreaming(SoundStream *stream)
+{
+    //Stop the reader before freeing what it works with
+    if(stream->thread)
+    {
+        SDL_AtomicSet(&stream->running, 0);
+        SDL_SemPost(stream->wake);
+        SDL_WaitThread(stream->thread, NULL);
+        stream->thread = NULL;
+    }
+    
+    if(stream->wake)
+    {
+        SDL_DestroySemaphore(stream->wake);
+        stream->wake = NULL;
+    }
+    
+    if(stream->convert)
+    {
+        SDL_FreeAudioStream(stream->convert);
+        stream->convert = NULL;
+    }
+    
+    #ifdef USE_VORBISFILE
+    if(stream->vorbis)
+    {
+        ov_clear(&stream->vorbisFile);
+        stream->vorbis = 0;
+    }
+    #endif
+    
+    SDL_free(stream->buffers[0]);
+    stream->buffers[0] = NULL;
+    stream->buffers[1] = NULL;
+}
+
+
+static int StartStreaming(SoundStream *stream, SDL_RWops *file)
+{
+    //Find a decoder that can read the file a piece at a time
+    Uint32 magic = 0;
+    SDL_AudioSpec spec;
+    SDL_memset(&spec, 0, sizeof(spec));
+    stream->file = file;
+    SDL_RWread(file, &magic, sizeof(magic), 1);
+    SDL_RWseek(file, 0, RW_SEEK_SET);
+    int failed = 1;
+    
+    if(SDL_SwapLE32(magic) == WAV_RIFF)
+    {
+        failed = OpenWav(stream, &spec);
+    }
+    #ifdef USE_VORBISFILE
+    else if(SDL_SwapLE32(magic) == OGG_MAGIC)
+    {
+        failed = OpenVorbis(stream, &spec);
+    }
+    #endif
+    
+    if(failed)
+    {
+        StopStreaming(stream);
+        stream->file = NULL;
+        return 1;
+    }
+    
+    //Convert to whatever SDL_mixer is playing
+    int rate;
+    Uint16 format;
+    int channels;
+    Mix_QuerySpec(&rate, &format, &channels);
+    stream->convert = SDL_NewAudioStream(spec.format, spec.channels, 
+        spec.freq, format, (Uint8)channels, rate);
+    
+    //SDL_AudioStreamGet only hands out whole frames, which don't always
+    //divide the buffers evenly
+    int frameSize = SDL_AUDIO_BITSIZE(format) / 8 * channels;
+    stream->bufferSize = STREAM_BUFFER_SIZE - STREAM_BUFFER_SIZE % frameSize;
+    stream->buffers[0] = (Uint8*)SDL_malloc(STREAM_BUFFER_SIZE * 2);
+    stream->buffers[1] = stream->buffers[0] + STREAM_BUFFER_SIZE;
+    stream->wake = SDL_CreateSemaphore(0);
+    
+    if(!stream->convert || !stream->buffers[0] || !stream->wake)
+    {
+        StopStreaming(stream);
+        stream->file = NULL;
+        return 1;
+    }
+    
+    //Have the first half ready before anything can be played
+    stream->sizes[0] = DecodeStream(stream, stream->buffers[0], 
+        stream->bufferSize);
+        
+    if(stream->sizes[0] < 0)
+    {
+        StopStreaming(stream);
+        stream->file = NULL;
+        return 1;
+    }
+    
+    SDL_AtomicSet(&stream->full[0], stream->sizes[0] > 0);
+    SDL_AtomicSet(&stream->ended, stream->sizes[0] < stream->bufferSize);
+    stream->fill = 1;
+    SDL_AtomicSet(&stream->running, 1);
+    stream->thread = SDL_CreateThread(&ReaderThread, "Stream", stream);
+    
+    if(!stream->thread)
+    {
+        StopStreaming(stream);
+        stream->file = NULL;
+        return 1;
+    }
+    
+    return 0;
+}
+
+
+int OpenSoundStream(SoundStream *stream, const char *path, int loop, 
+    int threshold)
+{
+    SDL_memset(stream, 0, sizeof(*stream));
+    stream->loop = loop;
+    SDL_RWops *file = SDL_RWFromFile(path, "rb");
+    
+    if(!file)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+        return 1;
+    }
+    
+    //Large files are streamed so they cost the same memory and startup
+    //time as small ones
+    if(threshold <= 0)
+    {
+        threshold = STREAM_THRESHOLD;
+    }
+    
+    if(SDL_RWsize(file) > threshold)
+    {
+        if(StartStreaming(stream, file) == 0)
+        {
+            SDL_Log("Streaming %s", path);
+            return 0;
+        }
+        
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, 
+            "Can't stream %s, loading all of it", path);
+        SDL_RWseek(file, 0, RW_SEEK_SET);
+    }
+    
+    //Everything else is decoded up front by SDL_mixer
+    stream->chunk = Mix_LoadWAV_RW(file, 1);
+    
+    if(!stream->chunk)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+        return 1;
+    }
+    
+    return 0;
+}
+
+
+void CloseSoundStream(SoundStream *stream)
+{
+    StopStreaming(stream);
+    
+    if(stream->starved)
+    {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, 
+            "Stream ran dry %i times", stream->starved);
+    }
+    
+    if(stream->file)
+    {
+        SDL_RWclose(stream->file);
+    }
+    
+    if(stream->chunk)
+    {
+        Mix_FreeChunk(stream->chunk);
+    }
+    
+    SDL_memset(stream, 0, sizeof(*stream));
+}
+
+
+static int ReadChunk(SoundStream *stream, Uint8 *dest, int len)
+{
+    int done = 0;
+    
+    while(done < len && stream->pos < stream->chunk->alen)
+    {
+        int count = (int)SDL_min((Uint32)(len - done), 
+            stream->chunk->alen - stream->pos);
+        SDL_memcpy(dest + done, stream->chunk->abuf + stream->pos, count);
+        done += count;
+        stream->pos += count;
+        
+        if(stream->pos == stream->chunk->alen && stream->loop)
+        {
+            stream->pos = 0;
+        }
+    }
+    
+    return done;
+}
+
+
+int ReadSoundStream(SoundStream *stream, Uint8 *dest, int len)
+{
+    //Called from the audio thread, so this never waits for the reader and
+    //only hands back what is already decoded
+    if(stream->chunk)
+    {
+        return ReadChunk(stream, dest, len);
+    }
+    
+    int done = 0;
+    
+    while(done < len)
+    {
+        int half = stream->playing;
+        
+        if(!SDL_AtomicGet(&stream->full[half]))
+        {
+            if(!SDL_AtomicGet(&stream->ended))
+            {
+                stream->starved++;
+            }
+            
+            break;
+        }
+        
+        int count = SDL_min(len - done, stream->sizes[half] - stream->playPos);
+        SDL_memcpy(dest + done, stream->buffers[half] + stream->playPos, 
+            count);
+        done += count;
+        stream->playPos += count;
+        
+        //Give a used up half back to the reader
+        if(stream->playPos == stream->sizes[half])
+        {
+            stream->playPos = 0;
+            stream->playing ^= 1;
+            SDL_AtomicSet(&stream->full[half], 0);
+            SDL_SemPost(stream->wake);
+        }
+    }
+    
+    return done;
+}
+
+
+static int SDLCALL ReaderThread(void *data)
+{
+    SoundStream *stream = (SoundStream*)data;
+    
+    //Refill whichever half the player is done with, and sleep while both
+    //are full
+    while(SDL_AtomicGet(&stream->running))
+    {
+        int half = stream->fill;
+        
+        if(SDL_AtomicGet(&stream->full[half]))
+        {
+            SDL_SemWait(stream->wake);
+            continue;
+        }
+        
+        int size = DecodeStream(stream, stream->buffers[half], 
+            stream->bufferSize);
+            
+        if(size > 0)
+        {
+            stream->sizes[half] = size;
+            SDL_AtomicSet(&stream->full[half], 1);
+            stream->fill ^= 1;
+        }
+        
+        if(size < stream->bufferSize)
+        {
+            SDL_AtomicSet(&stream->ended, 1);
+            break;
+        }
+    }
+    
+    return 0;
+}
@@ -0,0 +1,67 @@
+/*
+SDL2 Sound Streams
+*/
+
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_mixer.h>
+
+#ifdef USE_VORBISFILE
+#include <vorbis/vorbisfile.h>
+#endif
+
+
+//Macros
+//===========================================================================
+#define STREAM_THRESHOLD   (256 * 1024) //files larger than this are streamed
+#define STREAM_BUFFER_SIZE 65536        //bytes in each half of the ring
+#define STREAM_READ_SIZE   4096         //bytes read from the file at once
+
+
+//Types
+//===========================================================================
+//A sound is either decoded up front into a chunk, or decoded a piece at a
+//time by a reader thread. The reader fills one half of the ring while the
+//other half is played, and the two swap whenever the played half runs out.
+typedef struct
+{
+    Mix_Chunk *chunk;          //preloaded samples
+    Uint32 pos;                //next byte of the chunk to play
+    int loop;
+    
+    SDL_RWops *file;           //everything below is only used for streaming
+    int vorbis;
+    #ifdef USE_VORBISFILE
+    OggVorbis_File vorbisFile;
+    #endif
+    int frameSize;             //bytes per frame in the file
+    Sint64 dataStart;          //where the samples of a WAV file start
+    Uint32 dataSize;
+    Uint32 dataLeft;
+    SDL_AudioStream *convert;  //from the file's format to the mixer's
+    
+    Uint8 *buffers[2];
+    int bufferSize;            //most bytes decoded into a half at once
+    int sizes[2];
+    SDL_atomic_t full[2];      //set by the reader, cleared by the player
+    int playing;               //half the player reads from
+    int playPos;
+    int fill;                  //half the reader writes to next
+    int starved;               //times the player caught up with the reader
+    SDL_sem *wake;
+    SDL_Thread *thread;
+    SDL_atomic_t running;
+    SDL_atomic_t ended;
+} SoundStream;
+
+
+//Functions
+//===========================================================================
+int OpenSoundStream(SoundStream *stream, const char *path, int loop, 
+    int threshold);
+void CloseSoundStream(SoundStream *stream);
+int ReadSoundStream(SoundStream *stream, Uint8 *dest, int len);
+
+#endif
@@ -0,0 +1,253 @@
+/*
+SDL2 Frame Telemetry
+*/
+
+#include "telemetry.h"
+
+
+//Macros
+//===========================================================================
+#define TELEMETRY_MASK (TELEMETRY_CAPACITY - 1)
+
+
+//Types
+//===========================================================================
+typedef struct
+{
+    float samples[TELEMETRY_CAPACITY];
+    Uint32 count;
+} TelemetryRing;
+
+
+//Globals
+//===========================================================================
+static const char *seriesNames[TELEMETRY_SERIES_COUNT] = {
+    "events",
+    "update",
+    "draw",
+    "present",
+    "sleep",
+    "frame",
+    "jitter",
+    "input_latency",
+    "pop_latency",
+    "audio_latency",
+    "audio_underrun",
+    "audio_mix"
+};
+
+static TelemetryRing rings[TELEMETRY_SERIES_COUNT];
+static float scratch[TELEMETRY_CAPACITY];
+static Uint32 lastEventTimes[TELEMETRY_SERIES_COUNT];
+static double msPerTick = 0;
+static Uint64 frameStart = 0;
+static Uint64 phaseStart = 0;
+
+
+//Functions
+//===========================================================================
+void InitTelemetry(void)
+{
+    SDL_memset(rings, 0, sizeof(rings));
+    SDL_memset(lastEventTimes, 0, sizeof(lastEventTimes));
+    msPerTick = 1000.0 / SDL_GetPerformanceFrequency();
+    frameStart = SDL_GetPerformanceCounter();
+    phaseStart = frameStart;
+}
+
+
+void RecordTelemetry(TelemetrySeries series, float ms)
+{
+    //Overwrite the oldest sample once the ring is full
+    TelemetryRing *ring = &rings[series];
+    ring->samples[ring->count & TELEMETRY_MASK] = ms;
+    ring->count++;
+}
+
+
+void RecordTelemetrySince(TelemetrySeries series, Uint64 start)
+{
+    //Record the time since the given performance counter value. Unlike
+    //MarkTelemetryPhase this is safe to use from other threads as long as
+    //each series is only written by one thread.
+    Uint64 now = SDL_GetPerformanceCounter();
+    RecordTelemetry(series, (float)((now - start) * msPerTick));
+}
+
+
+void RecordEventLatency(TelemetrySeries series, Uint32 timestamp)
+{
+    //Record how old an event (timestamped with SDL_GetTicks) is, but only
+    //the first time it is reported so each event is counted once
+    if(timestamp == lastEventTimes[series])
+    {
+        return;
+    }
+    
+    lastEventTimes[series] = timestamp;
+    RecordTelemetry(series, (float)(SDL_GetTicks() - timestamp));
+}
+
+
+void MarkTelemetryPhase(TelemetrySeries phase)
+{
+    //Record the time since the previous mark
+    Uint64 now = SDL_GetPerformanceCounter();
+    RecordTelemetry(phase, (float)((now - phaseStart) * msPerTick));
+    phaseStart = now;
+}
+
+
+void EndTelemetryFrame(void)
+{
+    //Record the time since the previous frame ended
+    Uint64 now = SDL_GetPerformanceCounter();
+    RecordTelemetry(TELEMETRY_FRAME, (float)((now - frameStart) * msPerTick));
+    frameStart = now;
+    phaseStart = now;
+}
+
+
+static int CompareSamples(const void *a, const void *b)
+{
+    float x = *(const float*)a;
+    float y = *(const float*)b;
+    return (x > y) - (x < y);
+}
+
+
+static float Percentile(const float *sorted, Uint32 count, int percent)
+{
+    //Nearest-rank percentile
+    Uint32 rank = (count * percent + 99) / 100;
+    return sorted[rank ? rank - 1 : 0];
+}
+
+
+void GetTelemetryStats(TelemetrySeries series, TelemetryStats *stats)
+{
+    SDL_memset(stats, 0, sizeof(*stats));
+    
+    //Copy the valid part of the ring to the scratch buffer and sort it
+    TelemetryRing *ring = &rings[series];
+    Uint32 count = SDL_min(ring->count, TELEMETRY_CAPACITY);
+    
+    if(!count)
+    {
+        return;
+    }
+    
+    SDL_memcpy(scratch, ring->samples, count * sizeof(float));
+    SDL_qsort(scratch, count, sizeof(float), &CompareSamples);
+    
+    //Calculate stats
+    double sum = 0;
+    
+    for(Uint32 i = 0; i < count; i++)
+    {
+        sum += scratch[i];
+    }
+    
+    stats->count = count;
+    stats->mean = (float)(sum / count);
+    stats->p50 = Percentile(scratch, count, 50);
+    stats->p95 = Percentile(scratch, count, 95);
+    stats->p99 = Percentile(scratch, count, 99);
+    stats->max = scratch[count - 1];
+    
+    //Sort samples into power of 2 millisecond buckets
+    int bucket = 0;
+    float edge = 1;
+    
+    for(Uint32 i = 0; i < count; i++)
+    {
+        while(bucket < TELEMETRY_BUCKETS - 1 && scratch[i] > edge)
+        {
+            bucket++;
+            edge *= 2;
+        }
+        
+        stats->histogram[bucket]++;
+    }
+}
+
+
+int DumpTelemetry(const char *filename)
+{
+    //Nothing to do unless telemetry was asked for
+    if(!filename)
+    {
+        return 0;
+    }
+    
+    //Use JSON if the filename asks for it and CSV otherwise
+    size_t len = SDL_strlen(filename);
+    int json = len >= 5 && SDL_strcasecmp(filename + len - 5, ".json") == 0;
+    
+    SDL_RWops *file = SDL_RWFromFile(filename, "w");
+    
+    if(!file)
+    {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+        return 1;
+    }
+    
+    //Write one record per series
+    char line[512];
+    char hist[128];
+    
+    if(json)
+    {
+        SDL_RWwrite(file, "{\n", 1, 2);
+    }
+    else
+    {
+        SDL_strlcpy(line, "series,count,mean,p50,p95,p99,max,"
+            "le1,le2,le4,le8,le16,le32,le64,le128,gt128\n", sizeof(line));
+        SDL_RWwrite(file, line, 1, SDL_strlen(line));
+    }
+    
+    for(int i = 0; i < TELEMETRY_SERIES_COUNT; i++)
+    {
+        TelemetryStats stats;
+        GetTelemetryStats((TelemetrySeries)i, &stats);
+        
+        //Format the histogram
+        size_t histLen = 0;
+        hist[0] = '\0';
+        
+        for(int j = 0; j < TELEMETRY_BUCKETS; j++)
+        {
+            histLen += SDL_snprintf(hist + histLen, sizeof(hist) - histLen, 
+                "%s%u", j ? (json ? ", " : ",") : "", stats.histogram[j]);
+        }
+        
+        if(json)
+        {
+            SDL_snprintf(line, sizeof(line), "    \"%s\": {\"count\": %u, "
+                "\"mean\": %.3f, \"p50\": %.3f, \"p95\": %.3f, "
+                "\"p99\": %.3f, \"max\": %.3f, \"histogram\": [%s]}%s\n", 
+                seriesNames[i], stats.count, stats.mean, stats.p50, stats.p95,
+                stats.p99, stats.max, hist, 
+                i + 1 < TELEMETRY_SERIES_COUNT ? "," : "");
+        }
+        else
+        {
+            SDL_snprintf(line, sizeof(line), 
+                "%s,%u,%.3f,%.3f,%.3f,%.3f,%.3f,%s\n", seriesNames[i], 
+                stats.count, stats.mean, stats.p50, stats.p95, stats.p99, 
+                stats.max, hist);
+        }
+        
+        SDL_RWwrite(file, line, 1, SDL_strlen(line));
+    }
+    
+    if(json)
+    {
+        SDL_RWwrite(file, "}\n", 1, 2);
+    }
+    
+    SDL_RWclose(file);
+    SDL_Log("Telemetry written to %s", filename);
+    return 0;
+}
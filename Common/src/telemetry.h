@@ -0,0 +1,60 @@
+/*
+SDL2 Frame Telemetry
+*/
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <SDL2/SDL.h>
+
+
+//Macros
+//===========================================================================
+#define TELEMETRY_CAPACITY 4096 //samples kept per series (power of 2)
+#define TELEMETRY_BUCKETS  9    //histogram buckets (<=1, 2, 4 ... 128, >128 ms)
+
+
+//Types
+//===========================================================================
+typedef enum
+{
+    TELEMETRY_EVENTS,
+    TELEMETRY_UPDATE,
+    TELEMETRY_DRAW,
+    TELEMETRY_PRESENT,
+    TELEMETRY_SLEEP,
+    TELEMETRY_FRAME,
+    TELEMETRY_JITTER,
+    TELEMETRY_INPUT_LATENCY,
+    TELEMETRY_POP_LATENCY,
+    TELEMETRY_AUDIO_LATENCY,
+    TELEMETRY_AUDIO_UNDERRUN,
+    TELEMETRY_AUDIO_MIX,
+    TELEMETRY_SERIES_COUNT
+} TelemetrySeries;
+
+
+typedef struct
+{
+    Uint32 count;
+    float mean;
+    float p50;
+    float p95;
+    float p99;
+    float max;
+    Uint32 histogram[TELEMETRY_BUCKETS];
+} TelemetryStats;
+
+
+//Functions
+//===========================================================================
+void InitTelemetry(void);
+void RecordTelemetry(TelemetrySeries series, float ms);
+void RecordTelemetrySince(TelemetrySeries series, Uint64 start);
+void RecordEventLatency(TelemetrySeries series, Uint32 timestamp);
+void MarkTelemetryPhase(TelemetrySeries phase);
+void EndTelemetryFrame(void);
+void GetTelemetryStats(TelemetrySeries series, TelemetryStats *stats);
+int DumpTelemetry(const char *filename);
+
+#endif
@@ -0,0 +1,159 @@
+/*
+SDL2 Fixed Timestep
+*/
+
+#include "timestep.h"
+
+
+//Macros
+//===========================================================================
+#define MAX_STEPS_PER_FRAME 8
+
+
+//Functions
+//===========================================================================
+void InitTimestep(FixedTimestep *timestep, double hz)
+{
+    timestep->freq = SDL_GetPerformanceFrequency();
+    timestep->step = (Uint64)(timestep->freq / hz + 0.5);
+    timestep->accumulator = 0;
+    timestep->lastTime = SDL_GetPerformanceCounter();
+    timestep->maxSteps = MAX_STEPS_PER_FRAME;
+    timestep->lockstep = 0;
+    timestep->stepSem = NULL;
+    timestep->doneSem = NULL;
+}
+
+
+int SetTimestepLockstep(FixedTimestep *timestep, int lockstep)
+{
+    //In lockstep mode every frame advances the simulation by exactly one
+    //step regardless of real time, which makes runs reproducible. The
+    //render loop and the simulation thread hand each step back and forth
+    //through a pair of semaphores.
+    timestep->lockstep = lockstep;
+    timestep->accumulator = 0;
+    
+    if(!lockstep)
+    {
+        return 0;
+    }
+    
+    timestep->stepSem = SDL_CreateSemaphore(0);
+    timestep->doneSem = SDL_CreateSemaphore(0);
+    
+    if(!timestep->stepSem || !timestep->doneSem)
+    {
+        FreeTimestep(timestep);
+        return 1;
+    }
+    
+    return 0;
+}
+
+
+void FreeTimestep(FixedTimestep *timestep)
+{
+    if(timestep->stepSem)
+    {
+        SDL_DestroySemaphore(timestep->stepSem);
+        timestep->stepSem = NULL;
+    }
+    
+    if(timestep->doneSem)
+    {
+        SDL_DestroySemaphore(timestep->doneSem);
+        timestep->doneSem = NULL;
+    }
+    
+    timestep->lockstep = 0;
+}
+
+
+void BeginTimestep(FixedTimestep *timestep)
+{
+    //Accumulate the time that passed since the last frame
+    Uint64 now = SDL_GetPerformanceCounter();
+    timestep->accumulator += now - timestep->lastTime;
+    timestep->lastTime = now;
+    
+    if(timestep->lockstep)
+    {
+        timestep->accumulator = timestep->step;
+        return;
+    }
+    
+    //If we fell too far behind (window dragged, debugger break, etc.) drop
+    //the excess instead of trying to simulate all of it at once.
+    Uint64 limit = timestep->step * timestep->maxSteps;
+    
+    if(timestep->accumulator > limit)
+    {
+        timestep->accumulator = limit;
+    }
+}
+
+
+int StepTimestep(FixedTimestep *timestep)
+{
+    //Is there enough time left for another step?
+    if(timestep->accumulator < timestep->step)
+    {
+        return 0;
+    }
+    
+    timestep->accumulator -= timestep->step;
+    return 1;
+}
+
+
+Uint32 GetTimestepDelay(const FixedTimestep *timestep)
+{
+    //Whole milliseconds until the next step is due
+    if(timestep->lockstep || timestep->accumulator >= timestep->step)
+    {
+        return 0;
+    }
+    
+    return (Uint32)((timestep->step - timestep->accumulator) * 1000 / 
+        timestep->freq);
+}
+
+
+void WaitForNextStep(FixedTimestep *timestep)
+{
+    //Called by the simulation thread once it published a step. In lockstep
+    //mode it reports the step as done and waits to be allowed the next one,
+    //otherwise it sleeps until the next step is due.
+    if(timestep->lockstep)
+    {
+        SDL_SemPost(timestep->doneSem);
+        SDL_SemWait(timestep->stepSem);
+        return;
+    }
+    
+    SDL_Delay(GetTimestepDelay(timestep));
+}
+
+
+void WaitForStepDone(FixedTimestep *timestep)
+{
+    //Called by the render loop before it reads a snapshot, so in lockstep
+    //mode every frame shows the step that was allowed for it
+    if(timestep->lockstep)
+    {
+        SDL_SemWait(timestep->doneSem);
+    }
+}
+
+
+void AllowNextStep(FixedTimestep *timestep)
+{
+    //Called by the render loop once it has its snapshot, which lets the
+    //simulation work on the next step while the frame is drawn. It also
+    //wakes a simulation thread that has been told to stop.
+    if(timestep->lockstep)
+    {
+        SDL_SemPost(timestep->stepSem);
+    }
+}
@@ -0,0 +1,38 @@
+/*
+SDL2 Fixed Timestep
+*/
+
+#ifndef TIMESTEP_H
+#define TIMESTEP_H
+
+#include <SDL2/SDL.h>
+
+
+//Types
+//===========================================================================
+typedef struct
+{
+    Uint64 freq;        //performance counter ticks per second
+    Uint64 step;        //ticks per simulation step
+    Uint64 accumulator; //unsimulated time
+    Uint64 lastTime;    //when time was last accumulated
+    int maxSteps;       //most steps we will run in one frame
+    int lockstep;       //run exactly one step per frame
+    SDL_sem *stepSem;   //lockstep: posted by the render loop to allow a step
+    SDL_sem *doneSem;   //lockstep: posted by the simulation after a step
+} FixedTimestep;
+
+
+//Functions
+//===========================================================================
+void InitTimestep(FixedTimestep *timestep, double hz);
+int SetTimestepLockstep(FixedTimestep *timestep, int lockstep);
+void FreeTimestep(FixedTimestep *timestep);
+void BeginTimestep(FixedTimestep *timestep);
+int StepTimestep(FixedTimestep *timestep);
+Uint32 GetTimestepDelay(const FixedTimestep *timestep);
+void WaitForNextStep(FixedTimestep *timestep);
+void WaitForStepDone(FixedTimestep *timestep);
+void AllowNextStep(FixedTimestep *timestep);
+
+#endif
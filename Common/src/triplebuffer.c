@@ -0,0 +1,73 @@
+/*
+SDL2 Lock-Free Triple Buffer
+*/
+
+#include "triplebuffer.h"
+
+
+//Macros
+//===========================================================================
+#define INDEX_MASK 0x3
+#define DIRTY      0x4
+
+
+//Functions
+//===========================================================================
+int InitTripleBuffer(TripleBuffer *tb, size_t size)
+{
+    SDL_memset(tb, 0, sizeof(*tb));
+    
+    //Allocate the buffers
+    for(int i = 0; i < 3; i++)
+    {
+        tb->buffers[i] = SDL_calloc(1, size);
+        
+        if(!tb->buffers[i])
+        {
+            SDL_OutOfMemory();
+            FreeTripleBuffer(tb);
+            return 1;
+        }
+    }
+    
+    tb->front = 0;
+    SDL_AtomicSet(&tb->middle, 1);
+    tb->back = 2;
+    return 0;
+}
+
+
+void FreeTripleBuffer(TripleBuffer *tb)
+{
+    for(int i = 0; i < 3; i++)
+    {
+        SDL_free(tb->buffers[i]);
+        tb->buffers[i] = NULL;
+    }
+}
+
+
+void *GetWriteBuffer(TripleBuffer *tb)
+{
+    return tb->buffers[tb->back];
+}
+
+
+void PublishWriteBuffer(TripleBuffer *tb)
+{
+    //Swap the back buffer with the shared one and mark it as new
+    tb->back = SDL_AtomicSet(&tb->middle, tb->back | DIRTY) & INDEX_MASK;
+}
+
+
+const void *GetReadBuffer(TripleBuffer *tb)
+{
+    //Swap the front buffer with the shared one if something new was
+    //published since the last read
+    if(SDL_AtomicGet(&tb->middle) & DIRTY)
+    {
+        tb->front = SDL_AtomicSet(&tb->middle, tb->front) & INDEX_MASK;
+    }
+    
+    return tb->buffers[tb->front];
+}
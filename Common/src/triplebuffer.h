@@ -0,0 +1,33 @@
+/*
+SDL2 Lock-Free Triple Buffer
+*/
+
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <SDL2/SDL.h>
+
+
+//Types
+//===========================================================================
+//One writer thread fills the back buffer and publishes it, one reader
+//thread picks up the most recently published buffer. Neither side ever
+//waits for the other.
+typedef struct
+{
+    void *buffers[3];
+    SDL_atomic_t middle; //index of the shared buffer plus a dirty flag
+    int back;            //owned by the writer
+    int front;           //owned by the reader
+} TripleBuffer;
+
+
+//Functions
+//===========================================================================
+int InitTripleBuffer(TripleBuffer *tb, size_t size);
+void FreeTripleBuffer(TripleBuffer *tb);
+void *GetWriteBuffer(TripleBuffer *tb);
+void PublishWriteBuffer(TripleBuffer *tb);
+const void *GetReadBuffer(TripleBuffer *tb);
+
+#endif
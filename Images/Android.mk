@@ -4,9 +4,18 @@ LOCAL_MODULE := main
 LOCAL_C_INCLUDES := \
     ../deps/android/armeabi-v7a/SDL2/include \
     ../deps/android/armeabi-v7a/SDL2/include/SDL2 \
-    ../deps/android/armeabi-v7a/SDL2_image/include
+    ../deps/android/armeabi-v7a/SDL2_image/include \
+    ../Common/src
 LOCAL_SRC_FILES := \
-    src/main.c
+    src/main.c \
+    ../Common/src/pacer.c \
+    ../Common/src/telemetry.c \
+    ../Common/src/options.c \
+    ../Common/src/bench.c \
+    ../Common/src/assets.c \
+    ../Common/src/pack.c \
+    ../Common/src/pixels.c \
+    ../Common/src/damage.c
 LOCAL_LDFLAGS += \
     -LC:/android-sdk/ndk/19.2.5345600/toolchains/llvm/prebuilt/windows/lib/gcc/arm-linux-androideabi/4.9.x/armv7-a \
     -LC:/android-sdk/ndk/19.2.5345600/toolchains/llvm/prebuilt/windows/arm-linux-androideabi/lib/armv7-a \
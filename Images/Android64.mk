@@ -4,9 +4,18 @@ LOCAL_MODULE := main
 LOCAL_C_INCLUDES := \
     ../deps/android/arm64-v8a/SDL2/include \
     ../deps/android/arm64-v8a/SDL2/include/SDL2 \
-    ../deps/android/arm64-v8a/SDL2_image/include
+    ../deps/android/arm64-v8a/SDL2_image/include \
+    ../Common/src
 LOCAL_SRC_FILES := \
-    src/main.c
+    src/main.c \
+    ../Common/src/pacer.c \
+    ../Common/src/telemetry.c \
+    ../Common/src/options.c \
+    ../Common/src/bench.c \
+    ../Common/src/assets.c \
+    ../Common/src/pack.c \
+    ../Common/src/pixels.c \
+    ../Common/src/damage.c
 LOCAL_LDFLAGS += \
     -LC:/android-sdk/ndk/19.2.5345600/toolchains/llvm/prebuilt/windows/lib/gcc/aarch64-linux-android/4.9.x \
     -LC:/android-sdk/ndk/19.2.5345600/toolchains/llvm/prebuilt/windows/aarch64-linux-android/lib64 \
@@ -9,6 +9,14 @@ SDL2 Images Demo
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 
+#include "assets.h"
+#include "bench.h"
+#include "damage.h"
+#include "options.h"
+#include "pacer.h"
+#include "pixels.h"
+#include "telemetry.h"
+
 
 //Macros
 //===========================================================================
@@ -23,6 +31,8 @@ SDL2 Images Demo
 #define WINDOW_Y          SDL_WINDOWPOS_CENTERED
 #define WINDOW_WIDTH      800
 #define WINDOW_HEIGHT     600
+#define UPLOADS_PER_FRAME 2
+#define SPRITE_SCALE      200 //sprites are drawn at twice their image size
 
 #ifdef __ANDROID__
     #define WINDOW_FLAGS  SDL_WINDOW_FULLSCREEN
@@ -30,15 +40,12 @@ SDL2 Images Demo
     #define WINDOW_FLAGS  0
 #endif
 
-#define FPS               60
-#define TARGET_FRAME_TIME (1000 / FPS)
-
 
 //Types
 //===========================================================================
 typedef struct
 {
-    SDL_Texture *tex;
+    Asset *img;
     SDL_Rect rect;
     SDL_Point velocity;
 } Bubble;
@@ -51,15 +58,18 @@ SDL_Renderer *renderer = NULL;
 
 SDL_Point windowSize;
 
-int startTime = 0;
-int endTime = 0;
-int frameTime = 0;
+Options options;
+FramePacer pacer;
+DamageTracker damage;
 
 
 //Functions
 //===========================================================================
 void Quit(void)
 {
+    //Free cached assets
+    FreeAssetCache();
+    
     //Destroy renderer and window
     if(renderer)
     {
@@ -78,44 +88,21 @@ void Quit(void)
 }
 
 
-SDL_Texture *LoadImage(const char *filename, SDL_Rect *rect)
+//Entry Point
+//===========================================================================
+int main(int argc, char **argv)
 {
-    //Load the image file
-    SDL_Surface *img = IMG_Load(filename);
-    
-    if(!img)
-    {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
-        return NULL;
-    }
-    
-    //Fill out the given rect
-    if(rect)
+    //Parse command line options
+    if(ParseOptions(&options, argc, argv, OPTIONS_DIRTY_RECTS))
     {
-        rect->x = 0;
-        rect->y = 0;
-        rect->w = img->w;
-        rect->h = img->h;
+        return 1;
     }
     
-    //Create a texture from the image
-    SDL_Texture *tex = SDL_CreateTextureFromSurface(renderer, img);
-    
-    if(!tex)
+    if(options.bench)
     {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+        PrepareBenchMode();
     }
     
-    //Free the image and return the texture
-    SDL_FreeSurface(img);
-    return tex;
-}
-
-
-//Entry Point
-//===========================================================================
-int main(int argc, char **argv)
-{
     //Init SDL2
     SDL_Log("%s", "Initializing SDL2...");
     
@@ -139,14 +126,29 @@ int main(int argc, char **argv)
     //Create a window
     SDL_Log("%s", "Creating a window and renderer...");
     
-    if(SDL_CreateWindowAndRenderer(WINDOW_WIDTH, WINDOW_HEIGHT, WINDOW_FLAGS, 
-        &window, &renderer) == -1)
+    if(options.dirtyRects)
+    {
+        //The window surface keeps whatever we don't redraw
+        window = SDL_CreateWindow(APP_TITLE, WINDOW_X, WINDOW_Y, WINDOW_WIDTH, 
+            WINDOW_HEIGHT, WINDOW_FLAGS);
+        renderer = window ? CreateSurfaceRenderer(window) : NULL;
+    }
+    else
+    {
+        SDL_CreateWindowAndRenderer(WINDOW_WIDTH, WINDOW_HEIGHT, WINDOW_FLAGS, 
+            &window, &renderer);
+    }
+    
+    if(!window || !renderer)
     {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
         return 1;
     }
     
     SDL_SetWindowTitle(window, APP_TITLE);
+    InitPixelFormat(window, renderer);
+    InitAssetCache(renderer);
+    OpenAssetPack("data/assets.pack");
     SDL_SetWindowPosition(window, WINDOW_X, WINDOW_Y);
     
     #ifdef __ANDROID__
@@ -158,24 +160,31 @@ int main(int argc, char **argv)
     SDL_GetWindowSize(window, &windowSize.x, &windowSize.y);
     #endif
     
-    //Create a bubble
+    //Create a bubble and load its image in the background
     Bubble bubble;
-    bubble.tex = LoadImage("data/images/bubble.png", &bubble.rect);
+    bubble.img = LoadTextureAsync("data/images/bubble.png", SPRITE_SCALE);
     
-    if(!bubble.tex)
+    if(!bubble.img)
     {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", 
             "Failed to create a bubble.");
         return 1;
     }
     
-    bubble.rect.w *= 2;
-    bubble.rect.h *= 2;
+    bubble.rect.x = 0;
+    bubble.rect.y = 0;
+    bubble.rect.w = 0;
+    bubble.rect.h = 0;
     bubble.velocity.x = 1;
     bubble.velocity.y = 1;
     
     //Main Loop
     SDL_Log("%s", "Starting main loop...");
+    InitDamageTracker(&damage, window, renderer, options.dirtyRects);
+    InitFramePacer(&pacer, options.fps);
+    InitTelemetry();
+    StartBenchClock();
+    int frames = 0;
     
     while(TRUE)
     {
@@ -189,13 +198,44 @@ int main(int argc, char **argv)
             {
                 //Quit event
             case SDL_QUIT:
+                DumpTelemetry(options.telemetryFile);
                 return 0;
+                
+                //Key Down Event
+            case SDL_KEYDOWN:
+                //Dump telemetry on demand
+                if(event.key.keysym.sym == SDLK_F2)
+                {
+                    DumpTelemetry(options.telemetryFile);
+                }
+                
+                break;
+                
+                //Window Event
+            case SDL_WINDOWEVENT:
+                //The window contents may have been lost, and a resized
+                //window starts out with a blank surface
+                if(event.window.event == SDL_WINDOWEVENT_EXPOSED || 
+                    event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)
+                {
+                    DamageAll(&damage);
+                }
+                
+                //Keep the bubble bouncing off the new edges
+                if(event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)
+                {
+                    windowSize.x = event.window.data1;
+                    windowSize.y = event.window.data2;
+                }
+                
+                break;
             }
         }
         
-        //Clear the window
-        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
-        SDL_RenderClear(renderer);
+        MarkTelemetryPhase(TELEMETRY_EVENTS);
+        
+        //Upload images that have finished decoding
+        ProcessAssetUploads(UPLOADS_PER_FRAME);
         
         //Update the bubble
         bubble.rect.x += bubble.velocity.x;
@@ -211,20 +251,55 @@ int main(int argc, char **argv)
             bubble.velocity.y = -bubble.velocity.y;
         }
         
-        SDL_RenderCopy(renderer, bubble.tex, NULL, &bubble.rect);
+        MarkTelemetryPhase(TELEMETRY_UPDATE);
+        
+        //The bubble is drawn once its image has loaded
+        int bubbleReady = IsAssetReady(bubble.img);
+        
+        if(bubbleReady)
+        {
+            bubble.rect.w = bubble.img->size.x;
+            bubble.rect.h = bubble.img->size.y;
+        }
+        
+        //Redraw where the bubble was and where it is now
+        TrackDamage(&damage, 0, bubbleReady ? &bubble.rect : NULL);
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+        
+        for(int i = 0; BeginDamageRect(&damage, i); i++)
+        {
+            if(bubbleReady)
+            {
+                SDL_RenderCopy(renderer, bubble.img->data.tex, NULL, 
+                    &bubble.rect);
+            }
+        }
+        
+        MarkTelemetryPhase(TELEMETRY_DRAW);
         
         //Swap buffers
-        SDL_RenderPresent(renderer);
-        endTime = SDL_GetTicks();
-        frameTime = endTime - startTime;
-        startTime = endTime;
+        PresentDamage(&damage);
+        MarkTelemetryPhase(TELEMETRY_PRESENT);
+        
+        //Limit framerate
+        WaitForNextFrame(&pacer);
+        MarkTelemetryPhase(TELEMETRY_SLEEP);
+        RecordTelemetry(TELEMETRY_JITTER, (float)GetFrameJitter(&pacer));
+        EndTelemetryFrame();
         
-        //Limit framerate to 60 fps.
-        if(frameTime < TARGET_FRAME_TIME)
+        //Stop after the requested number of frames
+        if(++frames == options.frames)
         {
-            SDL_Delay(TARGET_FRAME_TIME - frameTime);
+            break;
         }
     }
     
+    //Report results
+    if(options.bench)
+    {
+        PrintBenchReport(APP_TITLE, frames);
+    }
+    
+    DumpTelemetry(options.telemetryFile);
     return 0;
 }
\ No newline at end of file
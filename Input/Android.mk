@@ -4,9 +4,28 @@ LOCAL_MODULE := main
 LOCAL_C_INCLUDES := \
     ../deps/android/armeabi-v7a/SDL2/include \
     ../deps/android/armeabi-v7a/SDL2/include/SDL2 \
-    ../deps/android/armeabi-v7a/SDL2_image/include
+    ../deps/android/armeabi-v7a/SDL2_image/include \
+    ../Common/src
 LOCAL_SRC_FILES := \
-    src/main.c
+    src/main.c \
+    ../Common/src/pacer.c \
+    ../Common/src/timestep.c \
+    ../Common/src/telemetry.c \
+    ../Common/src/options.c \
+    ../Common/src/bench.c \
+    ../Common/src/triplebuffer.c \
+    ../Common/src/events.c \
+    ../Common/src/atlas.c \
+    ../Common/src/assets.c \
+    ../Common/src/pack.c \
+    ../Common/src/pixels.c \
+    ../Common/src/batch.c \
+    ../Common/src/grid.c \
+    ../Common/src/bubbles.c \
+    ../Common/src/jobs.c \
+    ../Common/src/random.c \
+    ../Common/src/replay.c \
+    ../Common/src/simulation.c
 LOCAL_LDFLAGS += \
     -LC:/android-sdk/ndk/19.2.5345600/toolchains/llvm/prebuilt/windows/lib/gcc/arm-linux-androideabi/4.9.x/armv7-a \
     -LC:/android-sdk/ndk/19.2.5345600/toolchains/llvm/prebuilt/windows/arm-linux-androideabi/lib/armv7-a \
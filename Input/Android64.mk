@@ -4,9 +4,28 @@ LOCAL_MODULE := main
 LOCAL_C_INCLUDES := \
     ../deps/android/arm64-v8a/SDL2/include \
     ../deps/android/arm64-v8a/SDL2/include/SDL2 \
-    ../deps/android/arm64-v8a/SDL2_image/include
+    ../deps/android/arm64-v8a/SDL2_image/include \
+    ../Common/src
 LOCAL_SRC_FILES := \
-    src/main.c
+    src/main.c \
+    ../Common/src/pacer.c \
+    ../Common/src/timestep.c \
+    ../Common/src/telemetry.c \
+    ../Common/src/options.c \
+    ../Common/src/bench.c \
+    ../Common/src/triplebuffer.c \
+    ../Common/src/events.c \
+    ../Common/src/atlas.c \
+    ../Common/src/assets.c \
+    ../Common/src/pack.c \
+    ../Common/src/pixels.c \
+    ../Common/src/batch.c \
+    ../Common/src/grid.c \
+    ../Common/src/bubbles.c \
+    ../Common/src/jobs.c \
+    ../Common/src/random.c \
+    ../Common/src/replay.c \
+    ../Common/src/simulation.c
 LOCAL_LDFLAGS += \
     -LC:/android-sdk/ndk/19.2.5345600/toolchains/llvm/prebuilt/windows/lib/gcc/aarch64-linux-android/4.9.x \
     -LC:/android-sdk/ndk/19.2.5345600/toolchains/llvm/prebuilt/windows/aarch64-linux-android/lib64 \
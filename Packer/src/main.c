@@ -0,0 +1,377 @@
+/*
+SDL2 Asset Packer
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <SDL2/SDL_mixer.h>
+
+#ifdef USE_LZ4
+#include <lz4.h>
+#endif
+
+#include "pack.h"
+
+
+//Macros
+//===========================================================================
+#ifndef TRUE
+    #define TRUE  1
+    #define FALSE 0
+#endif
+
+#define SDL_INIT_FLAGS    SDL_INIT_AUDIO
+#define MAX_FILES         256
+
+
+//Types
+//===========================================================================
+typedef struct
+{
+    PackEntry entry;
+    void *data;          //bytes to write for this entry
+} Item;
+
+
+//Globals
+//===========================================================================
+Item items[MAX_FILES];
+int itemCount = 0;
+int useLZ4 = FALSE;
+
+
+//Functions
+//===========================================================================
+void Quit(void)
+{
+    //Free packed data
+    for(int i = 0; i < itemCount; i++)
+    {
+        SDL_free(items[i].data);
+    }
+    
+    //Quit SDL2
+    Mix_CloseAudio();
+    Mix_Quit();
+    IMG_Quit();
+    SDL_Quit();
+}
+
+
+int HasExtension(const char *filename, const char *ext)
+{
+    size_t len = SDL_strlen(filename);
+    size_t extLen = SDL_strlen(ext);
+    return len > extLen && 
+        SDL_strcasecmp(filename + len - extLen, ext) == 0;
+}
+
+
+void *CopyData(const void *src, size_t size)
+{
+    void *data = SDL_malloc(size);
+    
+    if(data)
+    {
+        SDL_memcpy(data, src, size);
+    }
+    
+    return data;
+}
+
+
+int PackImage(Item *item, const char *filename)
+{
+    //Decode the image and convert it to the pack pixel format
+    SDL_Surface *img = IMG_Load(filename);
+    
+    if(!img)
+    {
+        return 1;
+    }
+    
+    SDL_Surface *converted = SDL_ConvertSurfaceFormat(img, PACK_PIXEL_FORMAT, 
+        0);
+    SDL_FreeSurface(img);
+    
+    if(!converted)
+    {
+        return 1;
+    }
+    
+    item->entry.type = PACK_IMAGE;
+    item->entry.format = PACK_PIXEL_FORMAT;
+    item->entry.width = converted->w;
+    item->entry.height = converted->h;
+    item->entry.pitch = converted->pitch;
+    item->entry.rawSize = (Uint32)(converted->pitch * converted->h);
+    item->data = CopyData(converted->pixels, item->entry.rawSize);
+    SDL_FreeSurface(converted);
+    return !item->data;
+}
+
+
+int PackSound(Item *item, const char *filename)
+{
+    //Decode the sound and convert it to the mixer's device format
+    Mix_Chunk *chunk = Mix_LoadWAV(filename);
+    
+    if(!chunk)
+    {
+        return 1;
+    }
+    
+    item->entry.type = PACK_SOUND;
+    item->entry.rawSize = chunk->alen;
+    item->data = CopyData(chunk->abuf, chunk->alen);
+    Mix_FreeChunk(chunk);
+    return !item->data;
+}
+
+
+int PackFont(Item *item, const char *filename)
+{
+    //Fonts are read in place, so store the raw file
+    SDL_RWops *file = SDL_RWFromFile(filename, "rb");
+    
+    if(!file)
+    {
+        return 1;
+    }
+    
+    Sint64 size = SDL_RWsize(file);
+    item->entry.type = PACK_FONT;
+    item->entry.rawSize = size > 0 ? (Uint32)size : 0;
+    item->data = item->entry.rawSize ? SDL_malloc(item->entry.rawSize) : NULL;
+    
+    if(item->data && 
+        SDL_RWread(file, item->data, item->entry.rawSize, 1) != 1)
+    {
+        SDL_free(item->data);
+        item->data = NULL;
+    }
+    
+    SDL_RWclose(file);
+    return !item->data;
+}
+
+
+void CompressItem(Item *item)
+{
+    item->entry.size = item->entry.rawSize;
+    
+    #ifdef USE_LZ4
+    //Fonts have to stay uncompressed since they are read in place
+    if(!useLZ4 || item->entry.type == PACK_FONT)
+    {
+        return;
+    }
+    
+    int bound = LZ4_compressBound((int)item->entry.rawSize);
+    char *packed = (char*)SDL_malloc(bound);
+    
+    if(!packed)
+    {
+        return;
+    }
+    
+    int size = LZ4_compress_default((const char*)item->data, packed, 
+        (int)item->entry.rawSize, bound);
+        
+    //Only keep the compressed data if it saves at least 1/8
+    if(size > 0 && (Uint32)size < item->entry.rawSize - 
+        item->entry.rawSize / 8)
+    {
+        SDL_free(item->data);
+        item->data = packed;
+        item->entry.size = (Uint32)size;
+        item->entry.flags |= PACK_LZ4;
+    }
+    else
+    {
+        SDL_free(packed);
+    }
+    #endif
+}
+
+
+int AddFile(const char *filename)
+{
+    if(itemCount == MAX_FILES)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Too many files (max %i)", 
+            MAX_FILES);
+        return 1;
+    }
+    
+    if(SDL_strlen(filename) >= PACK_NAME_SIZE)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Name too long: %s", 
+            filename);
+        return 1;
+    }
+    
+    //Convert the file based on its type
+    Item *item = &items[itemCount];
+    SDL_memset(item, 0, sizeof(*item));
+    SDL_strlcpy(item->entry.name, filename, PACK_NAME_SIZE);
+    int result;
+    
+    if(HasExtension(filename, ".png") || HasExtension(filename, ".bmp") || 
+        HasExtension(filename, ".jpg"))
+    {
+        result = PackImage(item, filename);
+    }
+    else if(HasExtension(filename, ".ogg") || HasExtension(filename, ".wav"))
+    {
+        result = PackSound(item, filename);
+    }
+    else if(HasExtension(filename, ".ttf") || HasExtension(filename, ".otf"))
+    {
+        result = PackFont(item, filename);
+    }
+    else
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unknown file type: %s", 
+            filename);
+        return 1;
+    }
+    
+    if(result)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s: %s", filename, 
+            SDL_GetError());
+        SDL_free(item->data);
+        return 1;
+    }
+    
+    CompressItem(item);
+    SDL_Log("Packed %s (%u -> %u bytes)", filename, 
+        (unsigned)item->entry.rawSize, (unsigned)item->entry.size);
+    itemCount++;
+    return 0;
+}
+
+
+int WritePack(const char *filename, const PackHeader *header)
+{
+    //Lay out the data blocks after the index
+    Uint32 offset = (Uint32)(sizeof(PackHeader) + 
+        itemCount * sizeof(PackEntry));
+        
+    for(int i = 0; i < itemCount; i++)
+    {
+        offset = (offset + PACK_ALIGN - 1) & ~(Uint32)(PACK_ALIGN - 1);
+        items[i].entry.offset = offset;
+        offset += items[i].entry.size;
+    }
+    
+    //Write the header, the index and then the data
+    SDL_RWops *file = SDL_RWFromFile(filename, "wb");
+    
+    if(!file)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+        return 1;
+    }
+    
+    int ok = SDL_RWwrite(file, header, sizeof(PackHeader), 1) == 1;
+    
+    for(int i = 0; ok && i < itemCount; i++)
+    {
+        ok = SDL_RWwrite(file, &items[i].entry, sizeof(PackEntry), 1) == 1;
+    }
+    
+    static const Uint8 zeros[PACK_ALIGN] = {0};
+    
+    for(int i = 0; ok && i < itemCount; i++)
+    {
+        Sint64 pad = items[i].entry.offset - SDL_RWtell(file);
+        ok = (pad == 0 || SDL_RWwrite(file, zeros, (size_t)pad, 1) == 1) && 
+            SDL_RWwrite(file, items[i].data, items[i].entry.size, 1) == 1;
+    }
+    
+    if(SDL_RWclose(file) == -1 || !ok)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to write %s", 
+            filename);
+        return 1;
+    }
+    
+    SDL_Log("Wrote %s (%i assets, %u bytes)", filename, itemCount, 
+        (unsigned)offset);
+    return 0;
+}
+
+
+//Entry Point
+//===========================================================================
+int main(int argc, char **argv)
+{
+    //Parse command line options
+    int arg = 1;
+    
+    if(arg < argc && SDL_strcmp(argv[arg], "--lz4") == 0)
+    {
+        #ifdef USE_LZ4
+        useLZ4 = TRUE;
+        #else
+        fprintf(stderr, "%s\n", "Built without LZ4, --lz4 is ignored");
+        #endif
+        
+        arg++;
+    }
+    
+    if(argc - arg < 2)
+    {
+        fprintf(stderr, "Usage: %s [--lz4] OUTPUT FILE...\n", argv[0]);
+        return 1;
+    }
+    
+    const char *output = argv[arg++];
+    
+    //Init SDL2 with a silent audio device in the demos' mixer format
+    SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+    
+    if(SDL_Init(SDL_INIT_FLAGS) == -1)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+        return 1;
+    }
+    
+    atexit(&Quit);
+    
+    if(IMG_Init(IMG_INIT_PNG) != IMG_INIT_PNG || 
+        Mix_Init(MIX_INIT_OGG) != MIX_INIT_OGG || 
+        Mix_OpenAudio(MIX_DEFAULT_FREQUENCY, MIX_DEFAULT_FORMAT, 2, 4096) == -1)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+        return 1;
+    }
+    
+    PackHeader header;
+    SDL_memset(&header, 0, sizeof(header));
+    header.magic = PACK_MAGIC;
+    header.version = PACK_VERSION;
+    int freq;
+    int channels;
+    Mix_QuerySpec(&freq, &header.audioFormat, &channels);
+    header.audioFreq = freq;
+    header.audioChannels = (Uint16)channels;
+    
+    //Convert every file
+    for(; arg < argc; arg++)
+    {
+        if(AddFile(argv[arg]))
+        {
+            return 1;
+        }
+    }
+    
+    header.count = (Uint32)itemCount;
+    return WritePack(output, &header);
+}
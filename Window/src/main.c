@@ -8,6 +8,11 @@ SDL2 Window Demo
 
 #include <SDL2/SDL.h>
 
+#include "bench.h"
+#include "options.h"
+#include "pacer.h"
+#include "telemetry.h"
+
 
 //Macros
 //===========================================================================
@@ -29,18 +34,14 @@ SDL2 Window Demo
     #define WINDOW_FLAGS  0
 #endif
 
-#define FPS               60
-#define TARGET_FRAME_TIME (1000 / FPS)
-
 
 //Globals
 //===========================================================================
 SDL_Window *window = NULL;
 SDL_Renderer *renderer = NULL;
 
-int startTime = 0;
-int endTime = 0;
-int frameTime = 0;
+Options options;
+FramePacer pacer;
 
 
 //Functions
@@ -67,6 +68,17 @@ void Quit(void)
 //===========================================================================
 int main(int argc, char **argv)
 {
+    //Parse command line options
+    if(ParseOptions(&options, argc, argv, 0))
+    {
+        return 1;
+    }
+    
+    if(options.bench)
+    {
+        PrepareBenchMode();
+    }
+    
     //Init SDL2
     SDL_Log("%s", "Initializing SDL2...");
     
@@ -93,6 +105,10 @@ int main(int argc, char **argv)
     
     //Main Loop
     SDL_Log("%s", "Starting main loop...");
+    InitFramePacer(&pacer, options.fps);
+    InitTelemetry();
+    StartBenchClock();
+    int frames = 0;
     
     while(TRUE)
     {
@@ -106,26 +122,52 @@ int main(int argc, char **argv)
             {
                 //Quit event
             case SDL_QUIT:
+                DumpTelemetry(options.telemetryFile);
                 return 0;
+                
+                //Key Down Event
+            case SDL_KEYDOWN:
+                //Dump telemetry on demand
+                if(event.key.keysym.sym == SDLK_F2)
+                {
+                    DumpTelemetry(options.telemetryFile);
+                }
+                
+                break;
             }
         }
         
+        MarkTelemetryPhase(TELEMETRY_EVENTS);
+        
         //Clear the window
         SDL_SetRenderDrawColor(renderer, 0, 128, 255, 255);
         SDL_RenderClear(renderer);
         
+        MarkTelemetryPhase(TELEMETRY_DRAW);
+        
         //Swap buffers
         SDL_RenderPresent(renderer);
-        endTime = SDL_GetTicks();
-        frameTime = endTime - startTime;
-        startTime = endTime;
+        MarkTelemetryPhase(TELEMETRY_PRESENT);
+        
+        //Limit framerate
+        WaitForNextFrame(&pacer);
+        MarkTelemetryPhase(TELEMETRY_SLEEP);
+        RecordTelemetry(TELEMETRY_JITTER, (float)GetFrameJitter(&pacer));
+        EndTelemetryFrame();
         
-        //Limit framerate to 60 fps.
-        if(frameTime < TARGET_FRAME_TIME)
+        //Stop after the requested number of frames
+        if(++frames == options.frames)
         {
-            SDL_Delay(TARGET_FRAME_TIME - frameTime);
+            break;
         }
     }
     
+    //Report results
+    if(options.bench)
+    {
+        PrintBenchReport(APP_TITLE, frames);
+    }
+    
+    DumpTelemetry(options.telemetryFile);
     return 0;
 }
\ No newline at end of file